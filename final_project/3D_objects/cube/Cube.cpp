@@ -49,20 +49,20 @@ Cube::Cube(const std::vector<GLfloat> &vertex_buffer_data, const std::vector<GLf
     glBindVertexArray(0);
 }
 
-void Cube::render(const GLuint programID) {
-    GraphicsObject::render(programID);
+void Cube::render(const GLuint programID, const int instances) {
+    GraphicsObject::render(programID, instances);
 
     glBindVertexArray(vaoID);
 
     loadBuffers(programID);
 
     // Draw the box
-    glDrawElements(
+    glDrawElementsInstanced(
         GL_TRIANGLES,      // mode
         index_data_size,   // number of indices
         GL_UNSIGNED_INT,   // type
-        static_cast<void *>(nullptr) // element array buffer offset (void*) 0
-                   // element array buffer offset
+        static_cast<void *>(nullptr), // element array buffer offset (void*) 0
+        instances          // number of instances
     );
 
     disableVertexAttribArrays();
@@ -71,6 +71,22 @@ void Cube::render(const GLuint programID) {
     glBindVertexArray(0);
 }
 
+void Cube::renderDepth(const GLuint programID, const int instances, const std::vector<bool> &parts) {
+    GraphicsObject::render(programID, instances);
+
+    glBindVertexArray(vaoID);
+
+    // Positions only
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
+
+    glDrawElementsInstanced(GL_TRIANGLES, index_data_size, GL_UNSIGNED_INT, nullptr, instances);
+
+    glDisableVertexAttribArray(0);
+    glBindVertexArray(0);
+}
 
 void Cube::disableVertexAttribArrays() {
     glDisableVertexAttribArray(0);
@@ -102,3 +118,7 @@ void Cube::cleanup(){
     glDeleteBuffers(1, &normalBufferID);
     glDeleteVertexArrays(1, &vertexArrayID);
 }
+
+size_t Cube::getDepthTriangles(const std::vector<bool> &parts) const {
+    return index_data_size / 3;
+}
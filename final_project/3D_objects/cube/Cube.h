@@ -161,7 +161,10 @@ class Cube: public GraphicsObject{
         Cube();
         Cube(const std::vector<GLfloat> &vertex_buffer_data, const std::vector<GLfloat> &color_buffer_data, const std::vector<GLfloat> &normal_buffer_data, const std::vector<GLuint> &index_buffer_data);
 
-        void render(GLuint programID) override;
+        void render(GLuint programID, int instances) override;
+        void renderDepth(GLuint programID, int instances, const std::vector<bool> &parts) override;
+
+        [[nodiscard]] size_t getDepthTriangles(const std::vector<bool> &parts) const override;
         void cleanup() override;
         virtual void disableVertexAttribArrays();
         virtual void loadBuffers(GLuint programID);
@@ -4,8 +4,12 @@
 
 #include "GltfObject.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <stb_image.h>
 #include <stb_image_resize.h>
 #include <glm/gtc/matrix_transform.hpp>
@@ -13,9 +17,16 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <3D_objects/cube/Cube.h>
 #include <render/shader.h>
+#include <render/ProgramUniforms.h>
 #include <utils/texture_utils.h>
+#include <loaders/gltf_fast_loader/GltfFastLoader.h>
 #include "view_points/lights/light/Light.h"
 
+static const UniformName IGNORE_LIGHTING_PASS("ignoreLightingPass");
+static const UniformName TEXTURE_ARRAY("textureArray");
+static const UniformName DRAW_ID("drawID");
+static const UniformName RESOLVE_DRAWS("resolveDraws");
+
 GltfObject::GltfObject(const std::string &filePath) : GltfObject(filePath, false) {
 }
 
@@ -37,14 +48,20 @@ GltfObject::GltfObject(const std::string &filePath, bool animated) : GraphicsObj
     // Prepare animation data
     animationObjects = prepareAnimation(model);
 
-    loadMaterials();
+    materialLayers = loadMaterials(model);
+    compileDrawRecords();
+    initDepthBuffers();
+    initVertexFetch();
+    initJointBounds();
+    updateSkinnedBounds();
+    uploadMaterialData();
 
-    colorTexturesID = initTextureArrays(baseColorTexturesIndices);
+    colorTexturesID = initTextureArrays(materialLayers.baseColorTexturesIndices);
     if (!colorTexturesID) {
         std::cerr << "Failed to load color textures." << std::endl;
     }
 
-    metallicRoughnessTextureID = initTextureArrays(metallicRoughnessTexturesIndices);
+    metallicRoughnessTextureID = initTextureArrays(materialLayers.metallicRoughnessTexturesIndices);
     if (!metallicRoughnessTextureID) {
         std::cerr << "Failed to load metallic roughness textures." << std::endl;
     }
@@ -330,15 +347,25 @@ void GltfObject::update(float time) {
             updateAnimation(model, animation, animationObject, time, nodeTransforms);
             updateSkinning(nodeTransforms);
         }
+        updateSkinnedBounds();
     }
 }
 
 bool GltfObject::loadModel(tinygltf::Model &model, const char *filename) {
-    tinygltf::TinyGLTF loader;
     std::string err;
     std::string warn;
 
-    const bool res = loader.LoadASCIIFromFile(&model, &err, &warn, filename);
+    // Streaming parser first, tinygltf handles the files it does not support
+    bool res = GltfFastLoader::loadASCIIFromFile(model, err, warn, filename);
+    if (!res) {
+        std::cout << "Fast glTF loader failed, falling back to tinygltf: " << err;
+        err.clear();
+        warn.clear();
+
+        tinygltf::TinyGLTF loader;
+        res = loader.LoadASCIIFromFile(&model, &err, &warn, filename);
+    }
+
     if (!warn.empty()) {
         std::cout << "WARN: " << warn << std::endl;
     }
@@ -455,8 +482,8 @@ GLuint GltfObject::initTextureArrays(const std::vector<int> &textureIndices) con
     glGenTextures(1, &textureArrayID);
     glBindTexture(GL_TEXTURE_2D_ARRAY, textureArrayID);
 
-    constexpr int width = 1024;
-    constexpr int height = 1024;
+    constexpr int width = TEXTURE_ARRAY_SIZE;
+    constexpr int height = TEXTURE_ARRAY_SIZE;
     const int layerCount = static_cast<int>(textureIndices.size());
 
     glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, width, height, layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
@@ -492,7 +519,9 @@ GLuint GltfObject::initTextureArrays(const std::vector<int> &textureIndices) con
     return textureArrayID;
 }
 
-void GltfObject::loadMaterials() {
+MaterialLayers GltfObject::loadMaterials(const tinygltf::Model &model) {
+    MaterialLayers layers;
+
     for (int i = 0; i < model.materials.size(); i++) {
         const auto material = model.materials[i];
         Material materialData;
@@ -500,8 +529,8 @@ void GltfObject::loadMaterials() {
         if (material.values.find("baseColorTexture") != material.values.end()) {
             int textureIndex = material.values.at("baseColorTexture").TextureIndex();
 
-            baseColorMaterialIndices[i] = colorTexturesCount++;
-            baseColorTexturesIndices.push_back(textureIndex);
+            layers.baseColorMaterialIndices[i] = static_cast<int>(layers.baseColorTexturesIndices.size());
+            layers.baseColorTexturesIndices.push_back(textureIndex);
         } else if (material.values.find("baseColorFactor") != material.values.end()) {
             const auto &colorFactor = material.values.at("baseColorFactor").ColorFactor();
             materialData.baseColorFactor = glm::vec4(colorFactor[0], colorFactor[1], colorFactor[2], colorFactor[3]);
@@ -510,112 +539,770 @@ void GltfObject::loadMaterials() {
         if (material.values.find("metallicRoughnessTexture") != material.values.end()) {
             int textureIndex = material.values.at("metallicRoughnessTexture").TextureIndex();
 
-            metallicRoughnessMaterialIndices[i] = metallicRoughnessTextureCount++;
-            metallicRoughnessTexturesIndices.push_back(textureIndex);
+            layers.metallicRoughnessMaterialIndices[i] = static_cast<int>(layers.metallicRoughnessTexturesIndices.size());
+            layers.metallicRoughnessTexturesIndices.push_back(textureIndex);
         }
         if (material.additionalValues.find("emissiveFactor") != material.additionalValues.end()) {
             const auto &emissiveFactor = material.additionalValues.at("emissiveFactor").ColorFactor();
             materialData.emissiveFactor = glm::vec3(emissiveFactor[0], emissiveFactor[1], emissiveFactor[2]);
         }
 
-        materialsData[i] = materialData;
+        layers.materialsData[i] = materialData;
     }
+    return layers;
 }
 
-void GltfObject::drawMesh(const std::vector<PrimitiveObject> &primitiveObjects,
-                          const tinygltf::Model &model, const tinygltf::Mesh &mesh, GLuint programID) {
-    for (size_t i = 0; i < mesh.primitives.size(); ++i) {
-        glBindVertexArray(primitiveObjects[i].vao);
+void GltfObject::uploadMaterialData() {
+    std::vector<glm::vec4> table(MATERIAL_TEXELS * std::max<size_t>(model.materials.size(), 1), glm::vec4(1.0f));
 
-        const tinygltf::Primitive &primitive = mesh.primitives[i];
+    for (const auto &[i, material]: materialLayers.materialsData) {
+        const auto colorLayer = materialLayers.baseColorMaterialIndices.find(i);
+        const auto metLayer = materialLayers.metallicRoughnessMaterialIndices.find(i);
+        const int color = colorLayer != materialLayers.baseColorMaterialIndices.end() ? colorLayer->second : -1;
+        const int met = metLayer != materialLayers.metallicRoughnessMaterialIndices.end() ? metLayer->second : -1;
 
-        const tinygltf::Accessor &indexAccessor = model.accessors[primitive.indices];
+        glm::vec4 *texels = &table[i * MATERIAL_TEXELS];
+        texels[0] = material.baseColorFactor;
+        texels[1] = glm::vec4(static_cast<float>(color), static_cast<float>(met), 0.0f, 0.0f);
+    }
+
+    glGenBuffers(1, &materialTableBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, materialTableBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(table.size() * sizeof(glm::vec4)), table.data(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &materialTableTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, materialTableTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, materialTableBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
 
+void GltfObject::compileDrawRecordNodes(const tinygltf::Model &model, const MaterialLayers &materialLayers,
+                                        const int nodeIndex, const glm::mat4 &parentTransform,
+                                        std::vector<DrawRecord> &drawRecords) {
+    const tinygltf::Node &node = model.nodes[nodeIndex];
+    const glm::mat4 nodeTransform = parentTransform * getNodeTransform(node);
 
-        GLint metMaterialIDLocation = glGetUniformLocation(programID, "metTextureIndex");
-        glUniform1i(metMaterialIDLocation,
-                    (metallicRoughnessMaterialIndices.find(primitive.material) != metallicRoughnessMaterialIndices.
-                     end())
-                        ? metallicRoughnessTexturesIndices[primitive.
-                            material]
-                        : -1);
+    // Same traversal as bindModelNodes, so the records line up with the primitiveObjects it creates
+    if ((node.mesh >= 0) && (node.mesh < model.meshes.size())) {
+        for (const auto &primitive: model.meshes[node.mesh].primitives) {
+            if (primitive.indices < 0)
+                continue;
+
+            const tinygltf::Accessor &indexAccessor = model.accessors[primitive.indices];
+            const auto colorLayer = materialLayers.baseColorMaterialIndices.find(primitive.material);
+            const auto metLayer = materialLayers.metallicRoughnessMaterialIndices.find(primitive.material);
+            const auto material = materialLayers.materialsData.find(primitive.material);
+
+            DrawRecord draw{};
+            draw.mode = primitive.mode;
+            draw.count = static_cast<GLsizei>(indexAccessor.count);
+            draw.indexType = indexAccessor.componentType;
+            draw.indexOffset = BUFFER_OFFSET(indexAccessor.byteOffset);
+            draw.material = primitive.material;
+            draw.colorLayer = colorLayer != materialLayers.baseColorMaterialIndices.end() ? colorLayer->second : -1;
+            draw.metallicRoughnessLayer = metLayer != materialLayers.metallicRoughnessMaterialIndices.end()
+                                              ? metLayer->second
+                                              : -1;
+            draw.baseColorFactor = material != materialLayers.materialsData.end()
+                                       ? material->second.baseColorFactor
+                                       : glm::vec4(1.0f);
+            draw.nodeTransform = nodeTransform;
+            draw.firstFetchIndex = -1;
+            draw.primitive = &primitive;
+            drawRecords.push_back(draw);
+        }
+    }
 
-        GLint materialIDLocation = glGetUniformLocation(programID, "colorTextureIndex");
-        glUniform1i(materialIDLocation, (baseColorMaterialIndices.find(primitive.material) != baseColorMaterialIndices.
-                                         end())
-                                            ? baseColorMaterialIndices[primitive.material]
-                                            : -1);
+    for (const int i: node.children)
+        compileDrawRecordNodes(model, materialLayers, i, nodeTransform, drawRecords);
+}
 
-        materialIDLocation = glGetUniformLocation(programID, "baseColorFactor");
-        glUniform4fv(materialIDLocation, 1, value_ptr(materialsData[primitive.material].baseColorFactor));
+std::vector<DrawRecord> GltfObject::compileDrawRecords(const tinygltf::Model &model,
+                                                       const MaterialLayers &materialLayers) {
+    std::vector<DrawRecord> drawRecords;
+    const tinygltf::Scene &scene = model.scenes[model.defaultScene];
+    for (const int node: scene.nodes)
+        compileDrawRecordNodes(model, materialLayers, node, glm::mat4(1.0f), drawRecords);
+    return drawRecords;
+}
 
-        glDrawElements(primitive.mode,
-                       static_cast<int>(indexAccessor.count),
-                       indexAccessor.componentType,
-                       BUFFER_OFFSET(indexAccessor.byteOffset));
+void GltfObject::compileDrawRecords() {
+    hasBounds = false;
+    boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
 
-        // Unbind to avoid contamination
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, 0);
+    const tinygltf::Scene &scene = model.scenes[model.defaultScene];
+    if (scene.nodes.empty()) {
+        std::cerr << "Error: No nodes found in the default scene." << std::endl;
+        drawRecords.clear();
+        return;
+    }
+
+    drawRecords = compileDrawRecords(model, materialLayers);
+    hasBounds = !drawRecords.empty();
+    for (size_t i = 0; i < drawRecords.size(); i++) {
+        drawRecords[i].vao = primitiveObjects[i].vao;
+
+        // min and max are optional in glTF, a single primitive without them leaves the object unbounded
+        const tinygltf::Primitive &primitive = *drawRecords[i].primitive;
+        const auto position = primitive.attributes.find("POSITION");
+        const tinygltf::Accessor *accessor = position != primitive.attributes.end()
+                                                 ? &model.accessors[position->second]
+                                                 : nullptr;
+        if (accessor && accessor->minValues.size() >= 3 && accessor->maxValues.size() >= 3) {
+            boundsMin = glm::min(boundsMin, glm::vec3(accessor->minValues[0], accessor->minValues[1],
+                                                      accessor->minValues[2]));
+            boundsMax = glm::max(boundsMax, glm::vec3(accessor->maxValues[0], accessor->maxValues[1],
+                                                      accessor->maxValues[2]));
+        } else {
+            hasBounds = false;
+        }
     }
 }
 
-void GltfObject::drawModelNodes(const std::vector<PrimitiveObject> &primitiveObjects,
-                                tinygltf::Model &model, const tinygltf::Node &node, GLuint programID) {
-    // Draw the mesh at the node, and recursively do so for children nodes
-    if ((node.mesh >= 0) && (node.mesh < model.meshes.size())) {
-        drawMesh(primitiveObjects, model, model.meshes[node.mesh], programID);
+// Element i of an accessor, wherever its buffer view places it
+static const unsigned char *accessorElement(const tinygltf::Model &model, const tinygltf::Accessor &accessor,
+                                            const size_t i) {
+    const tinygltf::BufferView &bufferView = model.bufferViews[accessor.bufferView];
+    const size_t stride = accessor.ByteStride(bufferView);
+    return model.buffers[bufferView.buffer].data.data() + bufferView.byteOffset + accessor.byteOffset + i * stride;
+}
+
+// Component c of an element of unsigned integers, indices or joints
+static GLuint readUnsigned(const unsigned char *element, const int componentType, const int c) {
+    if (componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+        return element[c];
+    if (componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
+        GLushort value;
+        std::memcpy(&value, element + c * sizeof(GLushort), sizeof(value));
+        return value;
     }
-    for (const int i: node.children) {
-        drawModelNodes(primitiveObjects, model, model.nodes[i], programID);
+    GLuint value;
+    std::memcpy(&value, element + c * sizeof(GLuint), sizeof(value));
+    return value;
+}
+
+// Component c of an element of weights, which are floats or normalized unsigned integers
+static float readWeight(const unsigned char *element, const int componentType, const int c) {
+    if (componentType == TINYGLTF_COMPONENT_TYPE_FLOAT) {
+        float value;
+        std::memcpy(&value, element + c * sizeof(float), sizeof(value));
+        return value;
     }
+    const float max = componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE ? 255.0f : 65535.0f;
+    return static_cast<float>(readUnsigned(element, componentType, c)) / max;
 }
 
-void GltfObject::drawModel(const std::vector<PrimitiveObject> &primitiveObjects,
-                           tinygltf::Model &model, const GLuint programID) {
-    // Draw all nodes
-    const tinygltf::Scene &scene = model.scenes[model.defaultScene];
+// Replaces the triangle lists of the depth only stream with their shadow proxy, then drops the vertices no part
+// uses anymore. Vertices are welded by position and skin, which keeps differently skinned surfaces apart.
+void GltfObject::simplifyDepthParts(DepthStream &stream, const std::vector<std::pair<size_t, size_t> > &vertexRanges,
+                                    const ShadowProxySettings &shadowProxy) {
+    std::vector<unsigned char> &vertices = stream.vertices;
+    std::vector<GLuint> &indices = stream.indices;
+    const size_t stride = stream.stride;
+    const size_t vertexCount = vertices.size() / stride;
+    std::vector<glm::vec3> positions(vertexCount);
+    std::vector<uint64_t> skins;
+    std::map<std::string, uint64_t> skinKeys;
+    for (size_t v = 0; v < vertexCount; v++) {
+        std::memcpy(&positions[v], &vertices[v * stride], sizeof(glm::vec3));
+        if (stride > sizeof(glm::vec3)) {
+            const std::string skin(reinterpret_cast<const char *>(&vertices[v * stride + sizeof(glm::vec3)]),
+                                   stride - sizeof(glm::vec3));
+            skins.push_back(skinKeys.emplace(skin, skinKeys.size()).first->second);
+        }
+    }
 
-    if (scene.nodes.empty()) {
-        std::cerr << "Error: No nodes found in the default scene." << std::endl;
+    // Indices of vertices first to last, relative to first
+    auto simplify = [&](const size_t first, const size_t last, const std::vector<GLuint> &listIndices) {
+        const std::vector<glm::vec3> rangePositions(positions.begin() + first, positions.begin() + last);
+        const std::vector<uint64_t> rangeSkins = skins.empty()
+                                                     ? std::vector<uint64_t>()
+                                                     : std::vector<uint64_t>(skins.begin() + first,
+                                                                             skins.begin() + last);
+        std::vector<uint32_t> local(listIndices.size());
+        for (size_t i = 0; i < listIndices.size(); i++)
+            local[i] = listIndices[i] - static_cast<GLuint>(first);
+        const size_t target = static_cast<size_t>(std::ceil(shadowProxy.ratio * static_cast<float>(local.size() / 3)));
+        std::vector<GLuint> simplified = simplifyShadowProxy(rangePositions, rangeSkins, local, target,
+                                                             shadowProxy.maxError);
+        for (GLuint &index: simplified)
+            index += static_cast<GLuint>(first);
+        return simplified;
+    };
+
+    std::vector<GLuint> proxyIndices;
+    std::vector<DepthPart> proxyParts;
+    std::vector<GLuint> mergedIndices;
+    DepthPart merged{GL_TRIANGLES, 0, 0, true, glm::vec3(std::numeric_limits<float>::max()),
+                     glm::vec3(-std::numeric_limits<float>::max()), -1};
+    int mergedPart = -1;
+    for (size_t p = 0; p < stream.parts.size(); p++) {
+        DepthPart part = stream.parts[p];
+        const std::vector<GLuint> partIndices(indices.begin() + static_cast<long long>(part.firstIndex),
+                                              indices.begin() + static_cast<long long>(part.firstIndex + part.count));
+        if (part.mode == GL_TRIANGLES && shadowProxy.merge) {
+            mergedIndices.insert(mergedIndices.end(), partIndices.begin(), partIndices.end());
+            merged.bounded = merged.bounded && part.bounded;
+            merged.boundsMin = glm::min(merged.boundsMin, part.boundsMin);
+            merged.boundsMax = glm::max(merged.boundsMax, part.boundsMax);
+            // The merged part takes the place of the first list
+            if (mergedPart < 0) {
+                mergedPart = static_cast<int>(proxyParts.size());
+                proxyParts.push_back(merged);
+            }
+            continue;
+        }
+
+        const std::vector<GLuint> kept = part.mode == GL_TRIANGLES
+                                             ? simplify(vertexRanges[p].first, vertexRanges[p].second, partIndices)
+                                             : partIndices;
+        part.firstIndex = proxyIndices.size();
+        part.count = static_cast<GLsizei>(kept.size());
+        proxyIndices.insert(proxyIndices.end(), kept.begin(), kept.end());
+        proxyParts.push_back(part);
+    }
+    if (mergedPart >= 0) {
+        const std::vector<GLuint> kept = simplify(0, vertexCount, mergedIndices);
+        merged.firstIndex = proxyIndices.size();
+        merged.count = static_cast<GLsizei>(kept.size());
+        proxyIndices.insert(proxyIndices.end(), kept.begin(), kept.end());
+        proxyParts[mergedPart] = merged;
+    }
+
+    // Vertices in the order the indices first use them
+    std::vector<GLuint> remap(vertexCount, std::numeric_limits<GLuint>::max());
+    std::vector<unsigned char> proxyVertices;
+    for (GLuint &index: proxyIndices) {
+        if (remap[index] == std::numeric_limits<GLuint>::max()) {
+            remap[index] = static_cast<GLuint>(proxyVertices.size() / stride);
+            proxyVertices.insert(proxyVertices.end(), vertices.begin() + static_cast<long long>(index * stride),
+                                 vertices.begin() + static_cast<long long>((index + 1) * stride));
+        }
+        index = remap[index];
+    }
+
+    vertices = std::move(proxyVertices);
+    indices = std::move(proxyIndices);
+    stream.parts = std::move(proxyParts);
+}
+
+DepthStream GltfObject::buildDepthStream(const tinygltf::Model &model, const std::vector<DrawRecord> &drawRecords,
+                                         const bool skinned, const ShadowProxySettings &shadowProxy) {
+    DepthStream stream;
+    // Position, then 4 joints and 4 normalized weights as unsigned shorts
+    stream.stride = 3 * sizeof(float) + (skinned ? 8 * sizeof(GLushort) : 0);
+    const size_t stride = stream.stride;
+
+    std::vector<unsigned char> &vertices = stream.vertices;
+    std::vector<GLuint> &indices = stream.indices;
+    // First and past the last vertex of each part
+    std::vector<std::pair<size_t, size_t> > vertexRanges;
+
+    for (size_t d = 0; d < drawRecords.size(); d++) {
+        const DrawRecord &draw = drawRecords[d];
+        const tinygltf::Primitive &primitive = *draw.primitive;
+        const auto position = primitive.attributes.find("POSITION");
+        // Non-indexed primitives are not bound by bindMesh either
+        if (position == primitive.attributes.end() || primitive.indices < 0)
+            continue;
+        const auto joints = primitive.attributes.find("JOINTS_0");
+        const auto weights = primitive.attributes.find("WEIGHTS_0");
+        const bool weighted = skinned && joints != primitive.attributes.end() && weights != primitive.attributes.end();
+
+        const tinygltf::Accessor &positionAccessor = model.accessors[position->second];
+        const size_t baseVertex = vertices.size() / stride;
+        vertices.resize((baseVertex + positionAccessor.count) * stride);
+        for (size_t v = 0; v < positionAccessor.count; v++) {
+            unsigned char *vertex = &vertices[(baseVertex + v) * stride];
+            std::memcpy(vertex, accessorElement(model, positionAccessor, v), 3 * sizeof(float));
+            if (!weighted)
+                continue;
+
+            const tinygltf::Accessor &jointAccessor = model.accessors[joints->second];
+            const tinygltf::Accessor &weightAccessor = model.accessors[weights->second];
+            const unsigned char *joint = accessorElement(model, jointAccessor, v);
+            const unsigned char *weight = accessorElement(model, weightAccessor, v);
+            GLushort skin[8];
+            for (int c = 0; c < 4; c++) {
+                skin[c] = static_cast<GLushort>(readUnsigned(joint, jointAccessor.componentType, c));
+                skin[4 + c] = static_cast<GLushort>(
+                    std::lround(readWeight(weight, weightAccessor.componentType, c) * 65535.0f));
+            }
+            std::memcpy(vertex + 3 * sizeof(float), skin, sizeof(skin));
+        }
+
+        const tinygltf::Accessor &indexAccessor = model.accessors[primitive.indices];
+        const size_t firstIndex = indices.size();
+        for (size_t i = 0; i < indexAccessor.count; i++)
+            indices.push_back(static_cast<GLuint>(baseVertex) +
+                              readUnsigned(accessorElement(model, indexAccessor, i), indexAccessor.componentType, 0));
+
+        DepthPart part{draw.mode, static_cast<GLsizei>(indexAccessor.count), firstIndex, false, glm::vec3(0.0f),
+                       glm::vec3(0.0f), static_cast<int>(d)};
+        if (positionAccessor.minValues.size() >= 3 && positionAccessor.maxValues.size() >= 3) {
+            part.bounded = true;
+            part.boundsMin = glm::vec3(positionAccessor.minValues[0], positionAccessor.minValues[1],
+                                       positionAccessor.minValues[2]);
+            part.boundsMax = glm::vec3(positionAccessor.maxValues[0], positionAccessor.maxValues[1],
+                                       positionAccessor.maxValues[2]);
+        }
+        stream.parts.push_back(part);
+        vertexRanges.emplace_back(baseVertex, baseVertex + positionAccessor.count);
+    }
+    if (!stream.parts.empty())
+        simplifyDepthParts(stream, vertexRanges, shadowProxy);
+    return stream;
+}
+
+void GltfObject::initDepthBuffers() {
+    // Joints are only driven, in the draw data, for animated models
+    const bool skinned = !skinObjects.empty();
+    DepthStream stream = buildDepthStream(model, drawRecords, skinned, shadowProxy);
+    depthParts = std::move(stream.parts);
+    if (depthParts.empty())
         return;
+
+    const size_t stride = stream.stride;
+    const std::vector<unsigned char> &vertices = stream.vertices;
+    const std::vector<GLuint> &indices = stream.indices;
+
+    depthCorners.clear();
+    for (const DepthPart &part: skinned ? std::vector<DepthPart>() : depthParts) {
+        auto corner = [&](const size_t i) {
+            glm::vec3 position;
+            std::memcpy(&position, &vertices[indices[part.firstIndex + i] * stride], sizeof(position));
+            depthCorners.push_back(position);
+        };
+        for (GLsizei t = 0; t + 2 < part.count; t += part.mode == GL_TRIANGLES ? 3 : 1) {
+            if (part.mode == GL_TRIANGLES || part.mode == GL_TRIANGLE_STRIP) {
+                // Every other strip triangle is wound the other way, which a distance does not care about
+                corner(t);
+                corner(t + 1);
+                corner(t + 2);
+            } else if (part.mode == GL_TRIANGLE_FAN) {
+                corner(0);
+                corner(t + 1);
+                corner(t + 2);
+            }
+        }
     }
 
-    for (int node: scene.nodes) {
-        drawModelNodes(primitiveObjects, model, model.nodes[node], programID);
+    glGenVertexArrays(1, &depthVAO);
+    glBindVertexArray(depthVAO);
+
+    glGenBuffers(1, &depthVertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, depthVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<long long>(vertices.size()), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, static_cast<int>(stride), BUFFER_OFFSET(0));
+    glEnableVertexAttribArray(0);
+    if (skinned) {
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_SHORT, GL_FALSE, static_cast<int>(stride),
+                              BUFFER_OFFSET(3 * sizeof(float)));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(4, 4, GL_UNSIGNED_SHORT, GL_TRUE, static_cast<int>(stride),
+                              BUFFER_OFFSET(3 * sizeof(float) + 4 * sizeof(GLushort)));
+        glEnableVertexAttribArray(4);
+    }
+
+    // 16 bit indices whenever the vertices allow it
+    glGenBuffers(1, &depthIndexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, depthIndexBuffer);
+    if (vertices.size() / stride <= 65536) {
+        const std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+        depthIndexType = GL_UNSIGNED_SHORT;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<long long>(shortIndices.size() * sizeof(GLushort)),
+                     shortIndices.data(), GL_STATIC_DRAW);
+    } else {
+        depthIndexType = GL_UNSIGNED_INT;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<long long>(indices.size() * sizeof(GLuint)),
+                     indices.data(), GL_STATIC_DRAW);
+    }
+    glBindVertexArray(0);
+}
+
+GltfLoadStats GltfObject::buildLoadStats(const tinygltf::Model &model, const bool animated,
+                                         const ShadowProxySettings &shadowProxy) {
+    GltfLoadStats stats;
+    // The renderer only draws the default scene, a model without one draws nothing
+    if (model.defaultScene < 0 || model.defaultScene >= model.scenes.size())
+        return stats;
+
+    stats.drawRecords = compileDrawRecords(model, loadMaterials(model));
+    const bool skinned = animated && !prepareSkinning(model).empty();
+    stats.depthStream = buildDepthStream(model, stats.drawRecords, skinned, shadowProxy);
+    return stats;
+}
+
+// Component c of a vertex attribute, as glVertexAttribPointer hands it to the shaders
+static float readAttribute(const unsigned char *element, const int componentType, const bool normalized,
+                           const int c) {
+    switch (componentType) {
+        case TINYGLTF_COMPONENT_TYPE_BYTE: {
+            const auto value = static_cast<float>(reinterpret_cast<const int8_t *>(element)[c]);
+            return normalized ? std::max(value / 127.0f, -1.0f) : value;
+        }
+        case TINYGLTF_COMPONENT_TYPE_SHORT: {
+            int16_t value;
+            std::memcpy(&value, element + c * sizeof(int16_t), sizeof(value));
+            return normalized ? std::max(static_cast<float>(value) / 32767.0f, -1.0f) : static_cast<float>(value);
+        }
+        case TINYGLTF_COMPONENT_TYPE_FLOAT: {
+            float value;
+            std::memcpy(&value, element + c * sizeof(float), sizeof(value));
+            return value;
+        }
+        default: {
+            const auto value = static_cast<float>(readUnsigned(element, componentType, c));
+            const float max = componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE
+                                  ? 255.0f
+                                  : componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT
+                                        ? 65535.0f
+                                        : 4294967295.0f;
+            return normalized ? value / max : value;
+        }
+    }
+}
+
+void GltfObject::initVertexFetch() {
+    // gl_PrimitiveID counts the triangles of a draw, the resolve knows nothing of points and lines
+    for (const DrawRecord &draw: drawRecords)
+        if (draw.mode != GL_TRIANGLES && draw.mode != GL_TRIANGLE_STRIP && draw.mode != GL_TRIANGLE_FAN)
+            return;
+
+    std::vector<glm::vec4> vertices;
+    std::vector<GLuint> indices;
+    for (DrawRecord &draw: drawRecords) {
+        const tinygltf::Primitive &primitive = *draw.primitive;
+        const auto position = primitive.attributes.find("POSITION");
+        // Non-indexed primitives are not bound by bindMesh either
+        if (position == primitive.attributes.end() || primitive.indices < 0)
+            continue;
+        auto attribute = [&](const char *name) -> const tinygltf::Accessor * {
+            const auto found = primitive.attributes.find(name);
+            return found != primitive.attributes.end() ? &model.accessors[found->second] : nullptr;
+        };
+        const tinygltf::Accessor *accessors[] = {
+            &model.accessors[position->second], attribute("NORMAL"), attribute("TEXCOORD_0"), attribute("COLOR_0"),
+            attribute("JOINTS_0"), attribute("WEIGHTS_0")
+        };
+
+        // Attributes a primitive lacks read as the generic vertex attribute the geometry pass draws it with
+        const size_t baseVertex = vertices.size() / VERTEX_FETCH_TEXELS;
+        const size_t vertexCount = accessors[0]->count;
+        vertices.resize((baseVertex + vertexCount) * VERTEX_FETCH_TEXELS);
+        for (size_t v = 0; v < vertexCount; v++) {
+            glm::vec4 values[6];
+            for (int a = 0; a < 6; a++) {
+                values[a] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+                if (!accessors[a] || v >= accessors[a]->count)
+                    continue;
+                const tinygltf::Accessor &accessor = *accessors[a];
+                const unsigned char *element = accessorElement(model, accessor, v);
+                const int size = accessor.type == TINYGLTF_TYPE_SCALAR ? 1 : std::min(accessor.type, 4);
+                for (int c = 0; c < size; c++)
+                    values[a][c] = readAttribute(element, accessor.componentType, accessor.normalized, c);
+            }
+
+            glm::vec4 *vertex = &vertices[(baseVertex + v) * VERTEX_FETCH_TEXELS];
+            vertex[0] = glm::vec4(glm::vec3(values[0]), values[2].x);
+            vertex[1] = glm::vec4(glm::vec3(values[1]), values[2].y);
+            vertex[2] = values[3];
+            vertex[3] = values[4];
+            vertex[4] = values[5];
+        }
+
+        // Strips and fans unrolled, the n-th triangle of the draw is the n-th of the list
+        const tinygltf::Accessor &indexAccessor = model.accessors[primitive.indices];
+        auto index = [&](const size_t i) {
+            return static_cast<GLuint>(baseVertex) +
+                   readUnsigned(accessorElement(model, indexAccessor, i), indexAccessor.componentType, 0);
+        };
+        draw.firstFetchIndex = static_cast<int>(indices.size());
+        if (draw.mode == GL_TRIANGLES) {
+            for (size_t i = 0; i + 2 < indexAccessor.count; i += 3) {
+                indices.push_back(index(i));
+                indices.push_back(index(i + 1));
+                indices.push_back(index(i + 2));
+            }
+        } else {
+            for (size_t t = 0; t + 2 < indexAccessor.count; t++) {
+                indices.push_back(index(draw.mode == GL_TRIANGLE_FAN ? 0 : t));
+                indices.push_back(index(t + 1));
+                indices.push_back(index(t + 2));
+            }
+        }
     }
+
+    if (!vertexFetch.setup(vertices, indices))
+        for (DrawRecord &draw: drawRecords)
+            draw.firstFetchIndex = -1;
 }
 
-void GltfObject::render(const GLuint programID) {
-    GraphicsObject::render(programID);
+void GltfObject::initJointBounds() {
+    jointBounds.clear();
+    if (skinObjects.empty())
+        return;
 
-    const GLuint jointMatricesID = glGetUniformLocation(programID, "jointMatrices");
+    const size_t jointCount = skinObjects.back().jointMatrices.size();
+    jointBounds.assign(jointCount, {glm::vec3(std::numeric_limits<float>::max()),
+                                    glm::vec3(-std::numeric_limits<float>::max())});
+    for (const DrawRecord &draw: drawRecords) {
+        const tinygltf::Primitive &primitive = *draw.primitive;
+        const auto position = primitive.attributes.find("POSITION");
+        if (position == primitive.attributes.end())
+            continue;
+        const auto joints = primitive.attributes.find("JOINTS_0");
+        const auto weights = primitive.attributes.find("WEIGHTS_0");
+        const tinygltf::Accessor &positionAccessor = model.accessors[position->second];
+        const tinygltf::Accessor *jointAccessor = joints != primitive.attributes.end()
+                                                      ? &model.accessors[joints->second]
+                                                      : nullptr;
+        const tinygltf::Accessor *weightAccessor = weights != primitive.attributes.end()
+                                                       ? &model.accessors[weights->second]
+                                                       : nullptr;
+
+        for (size_t v = 0; v < positionAccessor.count; v++) {
+            glm::vec3 vertex;
+            std::memcpy(&vertex, accessorElement(model, positionAccessor, v), sizeof(vertex));
+            for (int c = 0; c < 4; c++) {
+                // Missing attributes read as the generic vertex attribute (0, 0, 0, 1), like in the shaders
+                const GLuint joint = jointAccessor && v < jointAccessor->count
+                                         ? readUnsigned(accessorElement(model, *jointAccessor, v),
+                                                        jointAccessor->componentType, c)
+                                         : (c == 3 ? 1u : 0u);
+                const float weight = weightAccessor && v < weightAccessor->count
+                                         ? readWeight(accessorElement(model, *weightAccessor, v),
+                                                      weightAccessor->componentType, c)
+                                         : (c == 3 ? 1.0f : 0.0f);
+                if (weight <= 0.0f)
+                    continue;
+                if (joint >= jointCount) {
+                    jointBounds.clear();
+                    return;
+                }
+                jointBounds[joint].first = glm::min(jointBounds[joint].first, vertex);
+                jointBounds[joint].second = glm::max(jointBounds[joint].second, vertex);
+            }
+        }
+    }
+}
 
-    for (const auto &skinObject: skinObjects)
-        glUniformMatrix4fv(static_cast<GLint>(jointMatricesID), static_cast<int>(skinObject.jointMatrices.size()),
-                           GL_FALSE, value_ptr(skinObject
-                               .jointMatrices[0]));
+void GltfObject::updateSkinnedBounds() {
+    hasSkinnedBounds = false;
+    if (jointBounds.empty())
+        return;
 
-    glUniform1i(glGetUniformLocation(programID, "ignoreLightingPass"), 0);
+    const std::vector<glm::mat4> &joints = skinObjects.back().jointMatrices;
+    skinnedBoundsMin = glm::vec3(std::numeric_limits<float>::max());
+    skinnedBoundsMax = glm::vec3(-std::numeric_limits<float>::max());
+    for (size_t j = 0; j < jointBounds.size(); j++) {
+        const auto &[min, max] = jointBounds[j];
+        if (min.x > max.x)
+            continue;
+        for (int corner = 0; corner < 8; corner++) {
+            const glm::vec3 point(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z);
+            const glm::vec3 moved = glm::vec3(joints[j] * glm::vec4(point, 1.0f));
+            skinnedBoundsMin = glm::min(skinnedBoundsMin, moved);
+            skinnedBoundsMax = glm::max(skinnedBoundsMax, moved);
+        }
+        hasSkinnedBounds = true;
+    }
+}
+
+void GltfObject::setShadowProxy(const ShadowProxySettings &settings) {
+    shadowProxy = settings;
+    glDeleteVertexArrays(1, &depthVAO);
+    glDeleteBuffers(1, &depthVertexBuffer);
+    glDeleteBuffers(1, &depthIndexBuffer);
+    depthVAO = depthVertexBuffer = depthIndexBuffer = 0;
+    initDepthBuffers();
+    invalidate();
+}
+
+const ShadowProxySettings &GltfObject::getShadowProxy() const {
+    return shadowProxy;
+}
+
+void GltfObject::writeDrawData(DrawDataRing &ring) {
+    // Only one skin drives the vertices, as with the jointMatrices uniform before
+    const std::vector<glm::mat4> *joints = skinObjects.empty() ? nullptr : &skinObjects.back().jointMatrices;
+    const int jointTexels = joints ? 4 * static_cast<int>(joints->size()) : 0;
+
+    glm::vec4 *data;
+    const int object = ring.allocate(
+        OBJECT_DATA_TEXELS + jointTexels + DRAW_RECORD_TEXELS * static_cast<int>(drawRecords.size()), data);
+
+    writeObjectData(data, getModelMatrix(), joints ? object + OBJECT_DATA_TEXELS : -1);
+    if (joints)
+        std::memcpy(data + OBJECT_DATA_TEXELS, joints->data(), jointTexels * sizeof(glm::vec4));
+
+    glm::vec4 *records = data + OBJECT_DATA_TEXELS + jointTexels;
+    for (size_t i = 0; i < drawRecords.size(); i++)
+        writeDrawRecord(records + i * DRAW_RECORD_TEXELS, object, drawRecords[i].material,
+                        drawRecords[i].firstFetchIndex);
+    firstDrawID = object + OBJECT_DATA_TEXELS + jointTexels;
+}
+
+bool GltfObject::getBounds(glm::vec3 &min, glm::vec3 &max) const {
+    if (!skinObjects.empty()) {
+        min = skinnedBoundsMin;
+        max = skinnedBoundsMax;
+        return hasSkinnedBounds;
+    }
+    if (!hasBounds)
+        return false;
+    min = boundsMin;
+    max = boundsMax;
+    return true;
+}
+
+void GltfObject::render(const GLuint programID, const int instances) {
+    GraphicsObject::render(programID, instances);
+    ProgramUniforms &uniforms = ProgramUniforms::get(programID);
+
+    uniforms.uniform<int>(IGNORE_LIGHTING_PASS).set(0);
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D_ARRAY, colorTexturesID);
 
-    glUniform1i(glGetUniformLocation(programID, "textureArray"), 0);
+    uniforms.uniform<int>(TEXTURE_ARRAY).set(0);
 
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D_ARRAY, metallicRoughnessTextureID);
 
-    const GLint metMaterialIDLocation = glGetUniformLocation(programID, "animated");
-    glUniform1i(metMaterialIDLocation, animated);
+    glActiveTexture(GL_TEXTURE0 + MATERIAL_TABLE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, materialTableTexture);
+
+    // Everything else the draws need was written in writeDrawData
+    const auto drawID = uniforms.uniform<int>(DRAW_ID);
 
     // Draw the GLTF graphics_object
-    drawModel(primitiveObjects, model, programID);
+    for (size_t i = 0; i < drawRecords.size(); i++) {
+        const DrawRecord &draw = drawRecords[i];
+        glBindVertexArray(draw.vao);
+
+        drawID.set(firstDrawID + static_cast<int>(i) * DRAW_RECORD_TEXELS);
+
+        glDrawElementsInstanced(draw.mode, draw.count, draw.indexType, draw.indexOffset, instances);
+    }
+    glBindVertexArray(0);
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glActiveTexture(GL_TEXTURE0 + MATERIAL_TABLE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+bool GltfObject::hasVisibilityResolve() const {
+    return vertexFetch.isReady();
+}
+
+void GltfObject::bindVisibilityResolve(const GLuint programID) {
+    glUseProgram(programID);
+    ProgramUniforms &uniforms = ProgramUniforms::get(programID);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, colorTexturesID);
+    uniforms.uniform<int>(TEXTURE_ARRAY).set(0);
+
+    glActiveTexture(GL_TEXTURE0 + MATERIAL_TABLE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, materialTableTexture);
+    vertexFetch.bind();
+
+    // The draw records of this frame, the pixels of any other draw are left to their own object
+    uniforms.uniform<glm::ivec2>(RESOLVE_DRAWS).set(
+        glm::ivec2(firstDrawID, firstDrawID + static_cast<int>(drawRecords.size()) * DRAW_RECORD_TEXELS));
+}
+
+int GltfObject::getPartCount() const {
+    return skinObjects.empty() ? static_cast<int>(depthParts.size()) : 0;
+}
+
+bool GltfObject::getPartBounds(const int part, glm::vec3 &min, glm::vec3 &max) const {
+    if (!skinObjects.empty() || !depthParts[part].bounded)
+        return false;
+    min = depthParts[part].boundsMin;
+    max = depthParts[part].boundsMax;
+    return true;
+}
+
+size_t GltfObject::getDepthTriangles(const std::vector<bool> &parts) const {
+    size_t triangles = 0;
+    for (size_t i = 0; i < depthParts.size(); i++) {
+        if (!parts.empty() && !parts[i])
+            continue;
+        const DepthPart &part = depthParts[i];
+        if (part.mode == GL_TRIANGLES)
+            triangles += part.count / 3;
+        else if ((part.mode == GL_TRIANGLE_STRIP || part.mode == GL_TRIANGLE_FAN) && part.count > 2)
+            triangles += part.count - 2;
+    }
+    return triangles;
+}
+
+bool GltfObject::getDepthGeometry(std::vector<glm::vec3> &corners) const {
+    if (depthCorners.empty())
+        return false;
+    corners.insert(corners.end(), depthCorners.begin(), depthCorners.end());
+    return true;
+}
+
+void GltfObject::renderDepth(const GLuint programID, const int instances, const std::vector<bool> &parts) {
+    if (depthParts.empty())
+        return;
+
+    glUseProgram(programID);
+    // Every draw record points at the same object data, the first one stands for all of them
+    ProgramUniforms::get(programID).uniform<int>(DRAW_ID).set(firstDrawID);
+
+    const size_t indexSize = depthIndexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    glBindVertexArray(depthVAO);
+
+    // Visible parts are gathered into runs, lists continue one another while strips and fans need a draw of their own
+    GLenum runMode = GL_TRIANGLES;
+    size_t runFirst = 0;
+    GLsizei runCount = 0;
+    auto drawRun = [&] {
+        if (runCount > 0)
+            glDrawElementsInstanced(runMode, runCount, depthIndexType, BUFFER_OFFSET(runFirst * indexSize),
+                                    instances);
+        runCount = 0;
+    };
+    for (size_t i = 0; i < depthParts.size(); i++) {
+        const DepthPart &part = depthParts[i];
+        if (!parts.empty() && !parts[i]) {
+            drawRun();
+            continue;
+        }
+
+        const bool list = part.mode == GL_TRIANGLES || part.mode == GL_LINES || part.mode == GL_POINTS;
+        if (runCount > 0 && list && part.mode == runMode && runFirst + runCount == part.firstIndex) {
+            runCount += part.count;
+            continue;
+        }
+        drawRun();
+        runMode = part.mode;
+        runFirst = part.firstIndex;
+        runCount = part.count;
+    }
+    drawRun();
+
+    glBindVertexArray(0);
+}
+
+void GltfObject::cleanup() {
+    GraphicsObject::cleanup();
+    glDeleteVertexArrays(1, &depthVAO);
+    glDeleteBuffers(1, &depthVertexBuffer);
+    glDeleteBuffers(1, &depthIndexBuffer);
+    vertexFetch.cleanup();
+    glDeleteTextures(1, &materialTableTexture);
+    glDeleteBuffers(1, &materialTableBuffer);
 }
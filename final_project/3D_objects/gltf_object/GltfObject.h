@@ -10,8 +10,16 @@
 #include "view_points/lights/light/Light.h"
 #include <tiny_gltf.h>
 #include "3D_objects/graphics_object/GraphicsObject.h"
+#include "render/VertexFetch.h"
+#include "ShadowProxy.h"
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
+// Every texture is resized to this size to fit in the texture arrays
+#define TEXTURE_ARRAY_SIZE 1024
+
+// Joints per skin budgeted for an asset, checked by the asset analyzer
+#define MAX_JOINTS 100
+
 // Texture types
 struct Material {
 	glm::vec4 baseColorFactor = glm::vec4(1.0f);
@@ -20,12 +28,65 @@ struct Material {
 	glm::vec3 roughnessFactor = glm::vec3(1.0f);
 };
 
+// Texels per material in the material table, mirrored in shaders/common/materials.glsl:
+//  base color factor, (base color layer, metallic roughness layer, 0, 0)
+// Only what the geometry pass reads is uploaded, the other factors stay on the CPU
+#define MATERIAL_TEXELS 2
+
 // Each VAO corresponds to each mesh primitive in the GLTF graphics_object
 struct PrimitiveObject {
 	GLuint vao;
 	std::map<int, GLuint> vbos;
 };
 
+// One draw call of the flattened node graph, resolved once at load time
+struct DrawRecord {
+	GLuint vao;
+	GLenum mode;
+	GLsizei count;
+	GLenum indexType;
+	const void *indexOffset;
+
+	int material;
+	int colorLayer;					// Layer in the base color texture array, -1 if untextured
+	int metallicRoughnessLayer;		// Layer in the metallic roughness texture array, -1 if untextured
+	glm::vec4 baseColorFactor;
+
+	glm::mat4 nodeTransform;		// World transform of the node in the glTF scene (not applied when drawing)
+	int firstFetchIndex;			// First index of its triangles in the vertex fetch buffers, -1 if not packed
+
+	const tinygltf::Primitive *primitive;	// Source of the depth only stream
+};
+
+// Draw record in the depth only stream, consecutive visible parts of a list mode are drawn at once
+struct DepthPart {
+	GLenum mode;
+	GLsizei count;
+	size_t firstIndex;
+
+	bool bounded;					// Whether the POSITION accessor has min and max
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+
+	int drawRecord;					// Draw record it was built from, -1 for the merged triangle lists
+};
+
+// Depth only stream of a model before its upload: positions, and 4 joints and 4 normalized weights as unsigned
+// shorts if skinned, with the parts drawing it
+struct DepthStream {
+	size_t stride = 0;
+	std::vector<unsigned char> vertices;
+	std::vector<GLuint> indices;
+	std::vector<DepthPart> parts;
+};
+
+// What the load time code builds from a model, made without touching OpenGL so the asset analyzer reports the
+// same draws and shadow proxy the renderer uploads
+struct GltfLoadStats {
+	std::vector<DrawRecord> drawRecords;	// Without their VAOs
+	DepthStream depthStream;
+};
+
 // Skinning
 struct SkinObject {
 	// Transforms the geometry into the space of the respective joint
@@ -55,6 +116,20 @@ struct AnimationObject {
 	std::vector<SamplerObject> samplers;	// Animation data
 };
 
+// Layout of the texture arrays built from the glTF materials
+struct MaterialLayers {
+	// base color
+	std::map<int, int> baseColorMaterialIndices;
+	std::vector<int> baseColorTexturesIndices;
+
+	// metallic roughness
+	std::map<int, int> metallicRoughnessMaterialIndices;
+	std::vector<int> metallicRoughnessTexturesIndices;
+
+	// Material array
+	std::map<int, Material> materialsData;
+};
+
 class GltfObject : public GraphicsObject{
 	private:
 		int animated;
@@ -62,21 +137,27 @@ class GltfObject : public GraphicsObject{
 		tinygltf::Model model;
 
 		std::vector<PrimitiveObject> primitiveObjects;
+		std::vector<DrawRecord> drawRecords;
+
+		// Union of the POSITION accessor bounds of the draw records
+		bool hasBounds = false;
+		glm::vec3 boundsMin = glm::vec3(0.0f);
+		glm::vec3 boundsMax = glm::vec3(0.0f);
+
+		// Bind pose bounds of the vertices each joint of the driving skin weighs, empty if not skinned or if a vertex
+		// names a joint the skin lacks. A skinned vertex is a blend of its joints' transforms, so the union of these
+		// boxes moved by the current joint matrices bounds the animated mesh.
+		std::vector<std::pair<glm::vec3, glm::vec3> > jointBounds;
+		bool hasSkinnedBounds = false;
+		glm::vec3 skinnedBoundsMin = glm::vec3(0.0f);
+		glm::vec3 skinnedBoundsMax = glm::vec3(0.0f);
+
+		// Draw data ring texel of the first draw record of this frame
+		int firstDrawID = 0;
 		std::vector<SkinObject> skinObjects;
 		std::vector<AnimationObject> animationObjects;
 
-		// base color
-		std::map<int, int> baseColorMaterialIndices;
-		std::vector<int> baseColorTexturesIndices;
-		int colorTexturesCount = 0;
-
-		// metallic roughness
-		std::map<int, int> metallicRoughnessMaterialIndices;
-		std::vector<int> metallicRoughnessTexturesIndices;
-	    int metallicRoughnessTextureCount = 0;
-
-		// Material array
-		std::map<int, Material> materialsData;
+		MaterialLayers materialLayers;
 
 		// Textures arrays
 		GLuint colorTexturesID = 0;
@@ -85,7 +166,23 @@ class GltfObject : public GraphicsObject{
 		GLuint occlusionTexturesID = 0;
 		GLuint metallicRoughnessTextureID = 0;
 
-		GLuint uboMaterials = 0;
+		// Every material of the model, indexed by the draw records
+		GLuint materialTableBuffer = 0;
+		GLuint materialTableTexture = 0;
+
+		// Depth only stream: positions, and joints and weights if skinned, of every draw record in one buffer. Its
+		// triangle lists are the shadow proxy, simplified at load time.
+		ShadowProxySettings shadowProxy;
+		GLuint depthVAO = 0;
+		GLuint depthVertexBuffer = 0;
+		GLuint depthIndexBuffer = 0;
+		GLenum depthIndexType = GL_UNSIGNED_INT;
+		std::vector<DepthPart> depthParts;
+		// Corners of every triangle of the stream, kept for the bakes of static casters, empty if skinned
+		std::vector<glm::vec3> depthCorners;
+
+		// Every draw record's vertices and triangles for the visibility resolve, empty if a draw is not triangles
+		VertexFetchBuffers vertexFetch;
 
 	public:
 		explicit GltfObject(const std::string& filePath);
@@ -119,7 +216,7 @@ class GltfObject : public GraphicsObject{
 
 		[[nodiscard]] GLuint loadTexture(int textureIndex) const;
 
-		void loadMaterials();
+		static MaterialLayers loadMaterials(const tinygltf::Model &model);
 
 		void initBuffers();
 
@@ -129,16 +226,59 @@ class GltfObject : public GraphicsObject{
 
 		void bindTextures();
 
-		void drawMesh(const std::vector<PrimitiveObject> &primitiveObjects, const tinygltf::Model &model,
-		              const tinygltf::Mesh &mesh, GLuint programID);
+		static void compileDrawRecordNodes(const tinygltf::Model &model, const MaterialLayers &materialLayers,
+										   int nodeIndex, const glm::mat4 &parentTransform,
+										   std::vector<DrawRecord> &drawRecords);
+		// Draw records of the default scene, in the order bindModel creates the VAOs, which it leaves at 0
+		static std::vector<DrawRecord> compileDrawRecords(const tinygltf::Model &model,
+														  const MaterialLayers &materialLayers);
+		void compileDrawRecords();
+
+		static void simplifyDepthParts(DepthStream &stream, const std::vector<std::pair<size_t, size_t> > &vertexRanges,
+									   const ShadowProxySettings &shadowProxy);
+		static DepthStream buildDepthStream(const tinygltf::Model &model, const std::vector<DrawRecord> &drawRecords,
+											bool skinned, const ShadowProxySettings &shadowProxy);
+		void initDepthBuffers();
+
+		// Draw records and depth only stream of a model loaded as GltfObject(filePath, animated) loads it
+		static GltfLoadStats buildLoadStats(const tinygltf::Model &model, bool animated,
+											const ShadowProxySettings &shadowProxy);
+
+		void initVertexFetch();
+
+		void initJointBounds();
+
+		// Moves jointBounds by the current joint matrices
+		void updateSkinnedBounds();
+
+		// Rebuilds the depth only stream, a ratio of 1 keeps every triangle
+		void setShadowProxy(const ShadowProxySettings &settings);
+
+		[[nodiscard]] const ShadowProxySettings &getShadowProxy() const;
+
+		void writeDrawData(DrawDataRing &ring) override;
+
+		// For skinned models, the bounds of the pose of the last update, from the joints' bind pose bounds
+		[[nodiscard]] bool getBounds(glm::vec3 &min, glm::vec3 &max) const override;
+
+		void render(GLuint programID, int instances) override;
+
+		[[nodiscard]] bool hasVisibilityResolve() const override;
+
+		void bindVisibilityResolve(GLuint programID) override;
+
+		// One part per draw record, none for skinned models
+		[[nodiscard]] int getPartCount() const override;
+
+		[[nodiscard]] bool getPartBounds(int part, glm::vec3 &min, glm::vec3 &max) const override;
+
+		[[nodiscard]] size_t getDepthTriangles(const std::vector<bool> &parts) const override;
 
-		void drawModelNodes(const std::vector<PrimitiveObject> &primitiveObjects, tinygltf::Model &model,
-		                    const tinygltf::Node &node, GLuint
-		                    programID);
+		[[nodiscard]] bool getDepthGeometry(std::vector<glm::vec3> &corners) const override;
 
-		void drawModel(const std::vector<PrimitiveObject> &primitiveObjects, tinygltf::Model &model, GLuint programID);
+		void renderDepth(GLuint programID, int instances, const std::vector<bool> &parts) override;
 
-		void render(GLuint programID) override;
+		void cleanup() override;
 };
 
 #endif //GLTFOBJECT_H
@@ -0,0 +1,265 @@
+#include "ShadowProxy.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+
+// Smallest cosine between a triangle's normal before and after a collapse, below it the collapse would fold the
+// surface over
+static constexpr double MIN_NORMAL_COSINE = 0.2;
+
+namespace {
+    // Sum of squared distances to a set of planes, as the symmetric matrix of the planes' outer products
+    struct Quadric {
+        double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+        void addPlane(const glm::dvec3 &normal, const double distance, const double weight) {
+            a2 += weight * normal.x * normal.x;
+            ab += weight * normal.x * normal.y;
+            ac += weight * normal.x * normal.z;
+            ad += weight * normal.x * distance;
+            b2 += weight * normal.y * normal.y;
+            bc += weight * normal.y * normal.z;
+            bd += weight * normal.y * distance;
+            c2 += weight * normal.z * normal.z;
+            cd += weight * normal.z * distance;
+            d2 += weight * distance * distance;
+        }
+
+        Quadric &operator+=(const Quadric &other) {
+            a2 += other.a2;
+            ab += other.ab;
+            ac += other.ac;
+            ad += other.ad;
+            b2 += other.b2;
+            bc += other.bc;
+            bd += other.bd;
+            c2 += other.c2;
+            cd += other.cd;
+            d2 += other.d2;
+            return *this;
+        }
+
+        [[nodiscard]] double error(const glm::dvec3 &p) const {
+            return a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x +
+                   b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y +
+                   c2 * p.z * p.z + 2 * cd * p.z + d2;
+        }
+    };
+
+    // Moves vertex from onto vertex to, valid while neither changed since it was queued
+    struct Collapse {
+        double cost;
+        uint32_t from, to;
+        uint32_t fromVersion, toVersion;
+
+        bool operator>(const Collapse &other) const {
+            return cost > other.cost;
+        }
+    };
+
+    using Triangle = std::array<uint32_t, 3>;
+
+    uint64_t edgeKey(const uint32_t a, const uint32_t b) {
+        return static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b);
+    }
+
+    glm::dvec3 triangleNormal(const glm::dvec3 &a, const glm::dvec3 &b, const glm::dvec3 &c) {
+        return glm::cross(b - a, c - a);
+    }
+}
+
+std::vector<uint32_t> simplifyShadowProxy(const std::vector<glm::vec3> &positions,
+                                          const std::vector<uint64_t> &keys,
+                                          const std::vector<uint32_t> &indices,
+                                          const size_t targetTriangles, const float maxError) {
+    // Weld the copies of a vertex the attributes the proxy drops had split, each points at the first of them
+    std::vector<uint32_t> order(positions.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto before = [&](const uint32_t a, const uint32_t b) {
+        const glm::vec3 &p = positions[a], &q = positions[b];
+        if (p.x != q.x)
+            return p.x < q.x;
+        if (p.y != q.y)
+            return p.y < q.y;
+        if (p.z != q.z)
+            return p.z < q.z;
+        return !keys.empty() && keys[a] < keys[b];
+    };
+    std::sort(order.begin(), order.end(), before);
+    std::vector<uint32_t> welded(positions.size());
+    for (size_t i = 0; i < order.size(); i++)
+        welded[order[i]] = i > 0 && !before(order[i - 1], order[i]) ? welded[order[i - 1]] : order[i];
+
+    std::vector<Triangle> triangles;
+    glm::vec3 boundsMin(std::numeric_limits<float>::max()), boundsMax(-std::numeric_limits<float>::max());
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const Triangle triangle{welded[indices[i]], welded[indices[i + 1]], welded[indices[i + 2]]};
+        if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0])
+            continue;
+        triangles.push_back(triangle);
+        for (const uint32_t v: triangle) {
+            boundsMin = glm::min(boundsMin, positions[v]);
+            boundsMax = glm::max(boundsMax, positions[v]);
+        }
+    }
+    if (triangles.empty())
+        return {};
+
+    const size_t vertexCount = positions.size();
+    std::vector<glm::dvec3> points(positions.begin(), positions.end());
+    std::vector<std::vector<uint32_t> > vertexTriangles(vertexCount);
+    std::unordered_map<uint64_t, int> edgeTriangles;
+    std::vector<Quadric> quadrics(vertexCount);
+    for (uint32_t t = 0; t < triangles.size(); t++) {
+        const Triangle &triangle = triangles[t];
+        const glm::dvec3 normal = triangleNormal(points[triangle[0]], points[triangle[1]], points[triangle[2]]);
+        const double length = glm::length(normal);
+        for (int c = 0; c < 3; c++) {
+            vertexTriangles[triangle[c]].push_back(t);
+            edgeTriangles[edgeKey(triangle[c], triangle[(c + 1) % 3])]++;
+            if (length > 0.0)
+                quadrics[triangle[c]].addPlane(normal / length, -glm::dot(normal / length, points[triangle[0]]), 1.0);
+        }
+    }
+
+    // Planes through the open edges, perpendicular to their triangle, keep the outlines where they are. Vertices on
+    // such edges, or on edges shared by more than two triangles, only slide along the open edges.
+    std::vector<bool> border(vertexCount, false);
+    for (const Triangle &triangle: triangles) {
+        const glm::dvec3 normal = triangleNormal(points[triangle[0]], points[triangle[1]], points[triangle[2]]);
+        for (int c = 0; c < 3; c++) {
+            const uint32_t a = triangle[c], b = triangle[(c + 1) % 3];
+            const int shared = edgeTriangles[edgeKey(a, b)];
+            if (shared == 2)
+                continue;
+            border[a] = border[b] = true;
+            const glm::dvec3 side = glm::cross(points[b] - points[a], normal);
+            const double length = glm::length(side);
+            if (shared != 1 || length == 0.0)
+                continue;
+            const glm::dvec3 sideNormal = side / length;
+            Quadric plane;
+            plane.addPlane(sideNormal, -glm::dot(sideNormal, points[a]), SHADOW_PROXY_BORDER_WEIGHT);
+            quadrics[a] += plane;
+            quadrics[b] += plane;
+        }
+    }
+
+    const double diagonal = glm::length(glm::dvec3(boundsMax - boundsMin));
+    const double maxCost = maxError * diagonal * maxError * diagonal;
+
+    std::vector<uint32_t> versions(vertexCount, 0);
+    std::vector<bool> removed(vertexCount, false);
+    std::vector<bool> deleted(triangles.size(), false);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<> > queue;
+    // Costs only grow as the quadrics gather planes, a collapse too costly now will never be done
+    auto enqueue = [&](const uint32_t from, const uint32_t to) {
+        Quadric quadric = quadrics[from];
+        quadric += quadrics[to];
+        const double cost = quadric.error(points[to]);
+        if (cost <= maxCost)
+            queue.push({cost, from, to, versions[from], versions[to]});
+    };
+    for (const auto &[key, shared]: edgeTriangles) {
+        enqueue(static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key));
+        enqueue(static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32));
+    }
+
+    auto neighbours = [&](const uint32_t v) {
+        std::vector<uint32_t> found;
+        for (const uint32_t t: vertexTriangles[v])
+            for (const uint32_t w: triangles[t])
+                if (w != v)
+                    found.push_back(w);
+        std::sort(found.begin(), found.end());
+        found.erase(std::unique(found.begin(), found.end()), found.end());
+        return found;
+    };
+
+    size_t remaining = triangles.size();
+    while (remaining > targetTriangles && !queue.empty()) {
+        const Collapse collapse = queue.top();
+        queue.pop();
+        const uint32_t from = collapse.from, to = collapse.to;
+        if (removed[from] || removed[to] || versions[from] != collapse.fromVersion ||
+            versions[to] != collapse.toVersion)
+            continue;
+
+        int shared = 0;
+        for (const uint32_t t: vertexTriangles[from])
+            shared += std::count(triangles[t].begin(), triangles[t].end(), to) > 0;
+        // Not an edge anymore, or one a border vertex would leave its border through
+        if (shared == 0 || shared > 2 || (border[from] && shared != 1))
+            continue;
+
+        // Vertices around both ends other than those of the collapsed triangles would pinch the surface
+        const std::vector<uint32_t> fromNeighbours = neighbours(from), toNeighbours = neighbours(to);
+        std::vector<uint32_t> common;
+        std::set_intersection(fromNeighbours.begin(), fromNeighbours.end(), toNeighbours.begin(), toNeighbours.end(),
+                              std::back_inserter(common));
+        if (common.size() != shared)
+            continue;
+
+        bool folds = false;
+        for (const uint32_t t: vertexTriangles[from]) {
+            const Triangle &triangle = triangles[t];
+            if (std::count(triangle.begin(), triangle.end(), to) > 0)
+                continue;
+            glm::dvec3 corners[3], moved[3];
+            for (int c = 0; c < 3; c++) {
+                corners[c] = points[triangle[c]];
+                moved[c] = triangle[c] == from ? points[to] : corners[c];
+            }
+            const glm::dvec3 normal = triangleNormal(corners[0], corners[1], corners[2]);
+            const glm::dvec3 movedNormal = triangleNormal(moved[0], moved[1], moved[2]);
+            const double lengths = glm::length(normal) * glm::length(movedNormal);
+            if (lengths == 0.0 || glm::dot(normal, movedNormal) < MIN_NORMAL_COSINE * lengths) {
+                folds = true;
+                break;
+            }
+        }
+        if (folds)
+            continue;
+
+        std::vector<uint32_t> &toTriangles = vertexTriangles[to];
+        for (const uint32_t t: vertexTriangles[from]) {
+            Triangle &triangle = triangles[t];
+            if (std::count(triangle.begin(), triangle.end(), to) > 0) {
+                deleted[t] = true;
+                toTriangles.erase(std::remove(toTriangles.begin(), toTriangles.end(), t), toTriangles.end());
+                remaining--;
+                continue;
+            }
+            std::replace(triangle.begin(), triangle.end(), from, to);
+            toTriangles.push_back(t);
+        }
+        // The collapsed triangles are still listed by their third vertex
+        for (const uint32_t w: common) {
+            std::vector<uint32_t> &list = vertexTriangles[w];
+            list.erase(std::remove_if(list.begin(), list.end(), [&deleted](const uint32_t t) { return deleted[t]; }),
+                       list.end());
+        }
+        vertexTriangles[from].clear();
+        removed[from] = true;
+        quadrics[to] += quadrics[from];
+        versions[to]++;
+
+        for (const uint32_t w: neighbours(to)) {
+            enqueue(w, to);
+            enqueue(to, w);
+        }
+    }
+
+    std::vector<uint32_t> simplified;
+    simplified.reserve(remaining * 3);
+    for (size_t t = 0; t < triangles.size(); t++)
+        if (!deleted[t])
+            simplified.insert(simplified.end(), triangles[t].begin(), triangles[t].end());
+    return simplified;
+}
@@ -0,0 +1,35 @@
+#ifndef SHADOWPROXY_H
+#define SHADOWPROXY_H
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Share of its triangles a shadow proxy keeps at most
+#define SHADOW_PROXY_RATIO 0.25f
+// Furthest a proxy may move the surface, relative to the diagonal of the simplified geometry's bounds
+#define SHADOW_PROXY_MAX_ERROR 0.01f
+// Weight of the planes holding open borders in place, relative to the planes of the triangles, so that holes and
+// outlines, which the silhouette is made of, do not shrink
+#define SHADOW_PROXY_BORDER_WEIGHT 16.0
+
+// How the depth only stream of a model is simplified into its shadow proxy
+struct ShadowProxySettings {
+    float ratio = SHADOW_PROXY_RATIO;
+    float maxError = SHADOW_PROXY_MAX_ERROR;
+    // Simplify the triangle lists of every part together and draw them as a single part, across the seams between
+    // primitives. Casters drawn whole, such as large static meshes seen by every view, save draws and triangles,
+    // but the views can no longer cull the parts one by one.
+    bool merge = false;
+};
+
+// Simplifies a triangle list by collapsing edges into one of their vertices, cheapest first by the quadric error
+// of the planes around the removed vertex, until targetTriangles remain or the next collapse would move the
+// surface further than maxError times the diagonal of the bounds. Only existing vertices are kept, so their other
+// attributes stay valid. Vertices at the same position are welded if their keys, when given, are equal too. The
+// result indexes the same vertices, without the degenerate triangles of the input.
+std::vector<uint32_t> simplifyShadowProxy(const std::vector<glm::vec3> &positions,
+                                          const std::vector<uint64_t> &keys,
+                                          const std::vector<uint32_t> &indices,
+                                          size_t targetTriangles, float maxError);
+
+#endif //SHADOWPROXY_H
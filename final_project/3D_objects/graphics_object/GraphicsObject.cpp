@@ -8,6 +8,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <3D_objects/cube/Cube.h>
 #include <render/shader.h>
+#include <render/ProgramUniforms.h>
+
+static const UniformName DRAW_ID("drawID");
 
 glm::mat4 GraphicsObject::getModelMatrix() const {
     auto model = glm::mat4(1.0f);
@@ -19,24 +22,95 @@ glm::mat4 GraphicsObject::getModelMatrix() const {
 
 void GraphicsObject::setScale(const glm::vec3 scale) {
     this->scale = scale;
+    version++;
 }
 
 void GraphicsObject::setTranslation(const glm::vec3 translation) {
     this->translation = translation;
+    version++;
 }
 
 void GraphicsObject::setRotation(const float rotation, const glm::vec3 rotationAxis) {
     this->rotation = rotation;
     this->rotationAxis = rotationAxis;
+    version++;
+}
+
+bool GraphicsObject::isStatic() const {
+    return staticObject;
+}
+
+void GraphicsObject::setStatic(const bool staticObject) {
+    this->staticObject = staticObject;
+    version++;
+}
+
+void GraphicsObject::invalidate() {
+    version++;
+}
+
+unsigned int GraphicsObject::getVersion() const {
+    return version;
+}
+
+bool GraphicsObject::castsShadows() const {
+    return shadowCaster;
+}
+
+void GraphicsObject::setCastsShadows(const bool castsShadows) {
+    shadowCaster = castsShadows;
+    version++;
+}
+
+bool GraphicsObject::getBounds(glm::vec3 &min, glm::vec3 &max) const {
+    return false;
+}
+
+int GraphicsObject::getPartCount() const {
+    return 0;
 }
 
-void GraphicsObject::render(const GLuint programID) {
+bool GraphicsObject::getPartBounds(const int part, glm::vec3 &min, glm::vec3 &max) const {
+    return false;
+}
+
+size_t GraphicsObject::getDepthTriangles(const std::vector<bool> &parts) const {
+    return 0;
+}
+
+bool GraphicsObject::hasVisibilityResolve() const {
+    return false;
+}
+
+void GraphicsObject::bindVisibilityResolve(const GLuint programID) {
+}
+
+bool GraphicsObject::isUnlit() const {
+    return false;
+}
+
+bool GraphicsObject::getDepthGeometry(std::vector<glm::vec3> &corners) const {
+    return false;
+}
+
+void GraphicsObject::writeDrawData(DrawDataRing &ring) {
+    glm::vec4 *data;
+    const int object = ring.allocate(OBJECT_DATA_TEXELS + DRAW_RECORD_TEXELS, data);
+
+    writeObjectData(data, getModelMatrix(), -1);
+    writeDrawRecord(data + OBJECT_DATA_TEXELS, object, -1, -1);
+    drawID = object + OBJECT_DATA_TEXELS;
+}
+
+void GraphicsObject::render(const GLuint programID, const int instances) {
     glUseProgram(programID);
 
-    modelMatrixID = glGetUniformLocation(programID, "model");
-    glUniformMatrix4fv(static_cast<int>(modelMatrixID), 1, GL_FALSE, &getModelMatrix()[0][0]);
+    ProgramUniforms::get(programID).uniform<int>(DRAW_ID).set(drawID);
+}
+
+void GraphicsObject::renderDepth(const GLuint programID, const int instances, const std::vector<bool> &parts) {
+    render(programID, instances);
 }
 
 void GraphicsObject::cleanup() {
-    glDeleteTextures(1, &modelMatrixID);
 }
\ No newline at end of file
@@ -4,10 +4,12 @@
 
 #ifndef GRAPHICS_OBJECT_H
 #define GRAPHICS_OBJECT_H
+#include <vector>
 #include <glm/detail/type_vec.hpp>
 #include <view_points/lights/light/Light.h>
 #include "glad/gl.h"
 #include <GLFW/glfw3.h>
+#include "render/DrawDataRing.h"
 
 class GraphicsObject {
     private:
@@ -16,7 +18,18 @@ class GraphicsObject {
         glm::vec3 scale = glm::vec3(1.0f);
         glm::vec3 rotationAxis = glm::vec3(0.0f, 1.0f, 0.0f);
 
-        GLuint modelMatrixID = -1;
+        // Draw record of this frame in the draw data ring
+        int drawID = 0;
+
+        // Static objects never move, passes may keep what they render of them between frames
+        bool staticObject = false;
+        bool shadowCaster = true;
+        // Incremented by every transform setter
+        unsigned int version = 0;
+
+    protected:
+        // Makes the passes drop what they kept of the object, when what it draws changes
+        void invalidate();
 
     public:
         explicit GraphicsObject() = default;
@@ -28,7 +41,49 @@ class GraphicsObject {
         void setRotation(float rotation, glm::vec3 rotationAxis);
         void setScale(glm::vec3 scale);
 
-        virtual void render(GLuint programID) = 0;
+        [[nodiscard]] bool isStatic() const;
+        void setStatic(bool staticObject);
+        [[nodiscard]] unsigned int getVersion() const;
+
+        // Objects that do not cast shadows are left out of the shadow maps
+        [[nodiscard]] bool castsShadows() const;
+        void setCastsShadows(bool castsShadows);
+
+        // Unlit objects keep the color the geometry pass writes, the lighting passes skip them
+        [[nodiscard]] virtual bool isUnlit() const;
+
+        // Object space bounding box of what render() draws, false when it is not known
+        [[nodiscard]] virtual bool getBounds(glm::vec3 &min, glm::vec3 &max) const;
+
+        // Pieces renderDepth() can leave out, each with its own object space bounding box. Objects without parts
+        // are culled as a whole.
+        [[nodiscard]] virtual int getPartCount() const;
+        [[nodiscard]] virtual bool getPartBounds(int part, glm::vec3 &min, glm::vec3 &max) const;
+
+        // Triangles renderDepth() draws per instance with these parts, 0 when it is not known
+        [[nodiscard]] virtual size_t getDepthTriangles(const std::vector<bool> &parts) const;
+
+        // Appends the object space corners of every triangle renderDepth() draws, three per triangle, for the
+        // bakes of static casters. False when they are not kept on the CPU or move with a skin.
+        [[nodiscard]] virtual bool getDepthGeometry(std::vector<glm::vec3> &corners) const;
+
+        // Writes this frame's per-draw constants, before any pass renders the object
+        virtual void writeDrawData(DrawDataRing &ring);
+
+        // Draws the object instances times, the shader tells them apart with gl_InstanceID
+        virtual void render(GLuint programID, int instances) = 0;
+
+        // Whether the visibility buffer of GeometryPass can shade what render() draws, from the triangles it
+        // fetches itself. Other objects are rasterized into the G-buffer as usual in that mode.
+        [[nodiscard]] virtual bool hasVisibilityResolve() const;
+
+        // Binds the materials, vertices and draw range of this frame's draws for the resolve of the visibility
+        // buffer, which then shades the pixels they cover
+        virtual void bindVisibilityResolve(GLuint programID);
+
+        // Draws only what a depth map needs, positions and skinning, without any material state. Objects without a
+        // depth only path draw as usual. parts flags the parts to draw, all of them when it is empty.
+        virtual void renderDepth(GLuint programID, int instances, const std::vector<bool> &parts);
 
         virtual void cleanup();
 };
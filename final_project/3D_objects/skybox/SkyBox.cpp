@@ -7,11 +7,17 @@
 #include <iostream>
 #include <ostream>
 #include <render/shader.h>
+#include <render/ProgramUniforms.h>
 
 #include "../../utils/texture_utils.h"
 
+static const UniformName IGNORE_LIGHTING_PASS("ignoreLightingPass");
+static const UniformName TEXTURE_SAMPLER("textureSampler");
+
 SkyBox::SkyBox() : Cube(default_vertex_buffer_data, default_color_buffer_data, default_normal_buffer_data, skybox_index_buffer_data){
     setScale(glm::vec3(100.0));
+    // Surrounds the camera, it would only ever shadow the whole scene
+    setCastsShadows(false);
 
     // Enable UV buffer and texture
     glGenBuffers(1, &uvBufferID);
@@ -31,13 +37,17 @@ void SkyBox::loadBuffers(const GLuint programID) {
     glBindBuffer(GL_ARRAY_BUFFER, uvBufferID);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
 
-    glUniform1i(glGetUniformLocation(programID, "ignoreLightingPass"), 1);
+    ProgramUniforms &uniforms = ProgramUniforms::get(programID);
+    uniforms.uniform<int>(IGNORE_LIGHTING_PASS).set(1);
 
-    // Set textureSampler to user texture unit 0
+    // Set textureSampler to user texture unit 3
     glActiveTexture(GL_TEXTURE3);
     glBindTexture(GL_TEXTURE_2D, textureID);
-    textureSamplerID = glGetUniformLocation(programID, "textureSampler");
-    glUniform1i(static_cast<int>(textureSamplerID), 3);
+    uniforms.uniform<int>(TEXTURE_SAMPLER).set(3);
+}
+
+bool SkyBox::isUnlit() const {
+    return true;
 }
 
 void SkyBox::disableVertexAttribArrays() {
@@ -67,12 +67,12 @@ inline const std::vector<GLuint> skybox_index_buffer_data = {
 class SkyBox : public Cube{
     GLuint uvBufferID = 0;
     GLuint textureID = 0;
-    GLuint textureSamplerID = 0;
 
     public:
         SkyBox();
         void disableVertexAttribArrays() override;
         void loadBuffers(GLuint programID) override;
+        [[nodiscard]] bool isUnlit() const override;
         void cleanup() override;
 };
 
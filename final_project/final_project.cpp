@@ -13,10 +13,13 @@
 #include <glm/detail/type_vec.hpp>
 
 #include "view_points/lights/spot_light/Spotlight.h"
+#include "view_points/lights/directional_light/DirectionalLight.h"
 #include "passes/geometry_pass/GeometryPass.h"
 #include "passes/lighting_pass/LightingPass.h"
 #include "passes/ssao_blur_pass/SSAOBlurPass.h"
 #include "passes/ssao_pass/SSAOPass.h"
+#include "render/DrawDataRing.h"
+#include "render/FrameUniforms.h"
 
 #define WIDTH 1024
 #define HEIGHT 768
@@ -25,6 +28,13 @@ static GLFWwindow *window;
 static void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 static void mouse_callback(GLFWwindow* window, double xPos, double yPos);
 
+// Passes whose modes the keys switch, the window title shows which ones run
+struct RenderModes {
+	LightingPass *lightingPass;
+	DepthPass *depthPass;
+	GeometryPass *geometryPass;
+};
+
 // OpenGL camera view parameters
 float cameraSensitivity = 0.001f;
 auto camera = Camera(-3.233, -0.535, glm::vec3(-6, 40, 68), 0.001, 45, 0.1f, 1800.0f);
@@ -76,7 +86,8 @@ int main()
 	auto spotLight2 = Spotlight(glm::vec3(-0.308003, 3.41245, 19.8179), 2, glm::vec3(1), -3.22801, 0.209002, 20, 30);
 	auto spotLight3 = Spotlight(glm::vec3(-8.88, 3.41245, 15.768), 2, glm::vec3(1), -3.88499, 0.132, 20, 30);
 	auto spotLight4 = Spotlight(glm::vec3(4.09714, 3.4899, 19.5193), 2, glm::vec3(1), -2.84999, 0.098001, 20, 30);
-	auto light = Light(glm::vec3(106.438, 57.1682, 9.46872), 1500, glm::vec3(1), -1.66101, -0.453002);
+	// Shining from around (106, 57, 9), as bright on the island as a 1500 point light there was
+	auto sun = DirectionalLight(0.1, glm::vec3(1), -1.66101, -0.453002);
 
 	auto skybox = SkyBox();
 	skybox.setScale(glm::vec3(1000));
@@ -88,16 +99,24 @@ int main()
 
 	auto island = GltfObject("../final_project/3D_assets/island/island.gltf");
 	island.setScale(glm::vec3(30));
+	// Its shadows are rendered once per light and cached
+	island.setStatic(true);
 
 	std::vector<GraphicsObject *> objects = {&zombie, &island, &skybox};
-	std::vector<Light *> lights = {&spotLight1, &spotLight2, &spotLight3, &spotLight4, &light};
+	std::vector<Light *> lights = {&spotLight1, &spotLight2, &spotLight3, &spotLight4, &sun};
+
+	// Uniform blocks shared by all the passes
+	auto frameUniforms = FrameUniforms(WIDTH, HEIGHT, lights);
+
+	// Per-draw constants of the objects, written once per frame
+	auto drawDataRing = DrawDataRing(16384);
 
 	// Passes
 	auto geometryPass = GeometryPass(WIDTH, HEIGHT);
 	auto ssaoPass = SSAOPass(WIDTH, HEIGHT, geometryPass);
-	auto ssaoBlurPass = SSAOBlurPass(WIDTH, HEIGHT, ssaoPass);
-	auto depthPass = DepthPass(8192, 8192, lights);
-	auto lightingPass = LightingPass(WIDTH, HEIGHT, lights, geometryPass, ssaoBlurPass, depthPass);
+	auto ssaoBlurPass = SSAOBlurPass(WIDTH, HEIGHT, ssaoPass, geometryPass);
+	auto depthPass = DepthPass(SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE, lights, frameUniforms);
+	auto lightingPass = LightingPass(WIDTH, HEIGHT, camera, lights, geometryPass, ssaoBlurPass, depthPass);
 
 	std::vector<RenderPass *> passes = {&geometryPass, &ssaoPass, &ssaoBlurPass, &depthPass, &lightingPass};
 
@@ -108,17 +127,37 @@ int main()
 	unsigned long frames = 0;
 	static float playbackSpeed = 1.0f;
 
+	frameUniforms.setup();
+	drawDataRing.setup(glfwGetProcAddress);
+	frameUniforms.setSSAOKernel(ssaoPass.getKernel());
+
 	for (const auto &pass: passes)
 		pass->setup();
 
+	// L switches the lighting strategy, E the shadow filtering, I the shadow submission, F how the static casters
+	// are shadowed and V the geometry mode
+	RenderModes renderModes = {&lightingPass, &depthPass, &geometryPass};
+	glfwSetWindowUserPointer(window, &renderModes);
+
 	do
 	{
 		skybox.setTranslation(camera.getPosition());
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// Picks the shadow maps to refresh and moves the sun's cascades, before their matrices are uploaded
+		depthPass.schedule(objects, camera, static_cast<float>(glfwGetTime() - lastTime));
+		frameUniforms.update(camera, time, static_cast<float>(glfwGetTime() - lastTime));
+
+		drawDataRing.beginFrame();
+		for (const auto &object: objects)
+			object->writeDrawData(drawDataRing);
+		drawDataRing.flush();
+
 		for (const auto &pass: passes)
 			pass->render(objects, camera);
 
+		drawDataRing.endFrame();
+
 		// Update states for animation
 		double currentTime = glfwGetTime();
 		auto deltaTime = static_cast<float>(currentTime - lastTime);
@@ -136,7 +175,12 @@ int main()
 			fTime = 0;
 
 			std::stringstream stream;
-			stream << std::fixed << std::setprecision(2) << "Final Project | Frames per second (FPS): " << fps;
+			stream << std::fixed << std::setprecision(2) << "Final Project | Frames per second (FPS): " << fps
+					<< (lightingPass.getStrategy() == LightingStrategy::STOCHASTIC ? " | Stochastic lighting" : "")
+					<< (depthPass.getFiltering() == ShadowFiltering::EVSM ? " | EVSM shadows" : "")
+					<< (depthPass.getSubmission() == ShadowSubmission::PER_VIEW ? " | Per view shadow draws" : "")
+					<< (depthPass.getStaticShadows() == StaticShadows::DISTANCE_FIELD ? " | SDF shadows" : "")
+					<< (geometryPass.getMode() == GeometryMode::VISIBILITY ? " | Visibility buffer" : "");
 			glfwSetWindowTitle(window, stream.str().c_str());
 		}
 
@@ -154,6 +198,9 @@ int main()
 	for (const auto &pass: passes)
 		pass->cleanup();
 
+	frameUniforms.cleanup();
+	drawDataRing.cleanup();
+
 	// Close OpenGL window and terminate GLFW
 	glfwTerminate();
 
@@ -164,6 +211,31 @@ int main()
 static void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode)
 {
 	camera.onKeyPress(window);
+
+	const auto *modes = static_cast<RenderModes *>(glfwGetWindowUserPointer(window));
+	if (!modes || action != GLFW_PRESS)
+		return;
+
+	if (key == GLFW_KEY_L)
+		modes->lightingPass->setStrategy(modes->lightingPass->getStrategy() == LightingStrategy::CLUSTERED
+			                                 ? LightingStrategy::STOCHASTIC
+			                                 : LightingStrategy::CLUSTERED);
+	if (key == GLFW_KEY_E)
+		modes->depthPass->setFiltering(modes->depthPass->getFiltering() == ShadowFiltering::HARD
+			                               ? ShadowFiltering::EVSM
+			                               : ShadowFiltering::HARD);
+	if (key == GLFW_KEY_I)
+		modes->depthPass->setSubmission(modes->depthPass->getSubmission() == ShadowSubmission::INSTANCED
+			                                ? ShadowSubmission::PER_VIEW
+			                                : ShadowSubmission::INSTANCED);
+	if (key == GLFW_KEY_F)
+		modes->depthPass->setStaticShadows(modes->depthPass->getStaticShadows() == StaticShadows::SHADOW_MAPS
+			                                   ? StaticShadows::DISTANCE_FIELD
+			                                   : StaticShadows::SHADOW_MAPS);
+	if (key == GLFW_KEY_V)
+		modes->geometryPass->setMode(modes->geometryPass->getMode() == GeometryMode::DEFERRED
+			                             ? GeometryMode::VISIBILITY
+			                             : GeometryMode::DEFERRED);
 }
 
 static void mouse_callback(GLFWwindow* window, const double xPos, const double yPos){
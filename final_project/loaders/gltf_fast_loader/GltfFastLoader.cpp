@@ -0,0 +1,838 @@
+#include "GltfFastLoader.h"
+
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(const Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Pull reader over an in-memory JSON document. Values are consumed in document order, anything the
+    // caller is not interested in is skipped by scanning for the matching delimiter instead of being parsed.
+    class JsonReader {
+        const char *begin;
+        const char *cur;
+        const char *end;
+        bool error = false;
+        std::string message;
+
+        // Storage for strings that contained escape sequences
+        std::string scratch;
+
+        void skipWhitespace() {
+            while (cur < end && (*cur == ' ' || *cur == '\n' || *cur == '\r' || *cur == '\t'))
+                ++cur;
+        }
+
+        void skipString() {
+            ++cur;
+            while (cur < end) {
+                const auto *quote = static_cast<const char *>(memchr(cur, '"', end - cur));
+                if (quote == nullptr)
+                    break;
+
+                // The quote is escaped if it is preceded by an odd number of backslashes
+                const char *p = quote;
+                while (p > cur && *(p - 1) == '\\')
+                    --p;
+                cur = quote + 1;
+                if ((quote - p) % 2 == 0)
+                    return;
+            }
+            fail("unterminated string");
+        }
+
+        static void appendUtf8(std::string &out, unsigned int codePoint) {
+            if (codePoint < 0x80) {
+                out += static_cast<char>(codePoint);
+            } else if (codePoint < 0x800) {
+                out += static_cast<char>(0xC0 | (codePoint >> 6));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else if (codePoint < 0x10000) {
+                out += static_cast<char>(0xE0 | (codePoint >> 12));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (codePoint >> 18));
+                out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        bool readHex4(unsigned int &value) {
+            if (end - cur < 4) {
+                fail("truncated unicode escape");
+                return false;
+            }
+            const auto result = std::from_chars(cur, cur + 4, value, 16);
+            if (result.ptr != cur + 4) {
+                fail("invalid unicode escape");
+                return false;
+            }
+            cur += 4;
+            return true;
+        }
+
+    public:
+        JsonReader(const char *begin, const char *end) : begin(begin), cur(begin), end(end) {
+        }
+
+        [[nodiscard]] bool failed() const {
+            return error;
+        }
+
+        [[nodiscard]] const std::string &getMessage() const {
+            return message;
+        }
+
+        void fail(const std::string &what) {
+            if (!error) {
+                error = true;
+                message = what + " (at byte " + std::to_string(cur - begin) + ")";
+            }
+            cur = end;
+        }
+
+        char peek() {
+            skipWhitespace();
+            return cur < end ? *cur : '\0';
+        }
+
+        bool expect(const char c) {
+            if (peek() == c) {
+                ++cur;
+                return true;
+            }
+            fail(std::string("expected '") + c + "'");
+            return false;
+        }
+
+        bool beginObject() {
+            return expect('{');
+        }
+
+        bool beginArray() {
+            return expect('[');
+        }
+
+        // Moves to the next member of the current object, returns false once the closing brace is consumed
+        bool nextMember(std::string_view &key) {
+            char c = peek();
+            if (c == ',') {
+                ++cur;
+                c = peek();
+            }
+            if (c == '}') {
+                ++cur;
+                return false;
+            }
+            if (c != '"') {
+                fail("expected member name");
+                return false;
+            }
+            return readString(key) && expect(':');
+        }
+
+        // Moves to the next element of the current array, returns false once the closing bracket is consumed
+        bool nextElement() {
+            char c = peek();
+            if (c == ',') {
+                ++cur;
+                c = peek();
+            }
+            if (c == ']') {
+                ++cur;
+                return false;
+            }
+            if (c == '\0') {
+                fail("unterminated array");
+                return false;
+            }
+            return !error;
+        }
+
+        // The returned view points either into the document or into the scratch storage, it is only valid
+        // until the next string is read.
+        bool readString(std::string_view &out) {
+            if (!expect('"'))
+                return false;
+
+            const char *start = cur;
+            while (cur < end && *cur != '"' && *cur != '\\')
+                ++cur;
+
+            if (cur < end && *cur == '"') {
+                out = std::string_view(start, cur - start);
+                ++cur;
+                return true;
+            }
+
+            // Slow path, the string contains escape sequences
+            scratch.assign(start, cur - start);
+            while (cur < end && *cur != '"') {
+                if (*cur != '\\') {
+                    scratch += *cur++;
+                    continue;
+                }
+                if (++cur >= end)
+                    break;
+
+                switch (const char escaped = *cur++) {
+                    case 'b': scratch += '\b';
+                        break;
+                    case 'f': scratch += '\f';
+                        break;
+                    case 'n': scratch += '\n';
+                        break;
+                    case 'r': scratch += '\r';
+                        break;
+                    case 't': scratch += '\t';
+                        break;
+                    case 'u': {
+                        unsigned int codePoint;
+                        if (!readHex4(codePoint))
+                            return false;
+                        if (codePoint >= 0xD800 && codePoint < 0xDC00 && end - cur >= 6 && cur[0] == '\\' && cur[1] == 'u') {
+                            cur += 2;
+                            unsigned int low;
+                            if (!readHex4(low))
+                                return false;
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        appendUtf8(scratch, codePoint);
+                        break;
+                    }
+                    default: scratch += escaped;
+                }
+            }
+            if (cur >= end) {
+                fail("unterminated string");
+                return false;
+            }
+            ++cur;
+            out = scratch;
+            return true;
+        }
+
+        bool readString(std::string &out) {
+            std::string_view view;
+            if (!readString(view))
+                return false;
+            out.assign(view.data(), view.size());
+            return true;
+        }
+
+        bool readNumber(double &out) {
+            skipWhitespace();
+            const auto result = std::from_chars(cur, end, out);
+            if (result.ec != std::errc()) {
+                fail("expected number");
+                return false;
+            }
+            cur = result.ptr;
+            return true;
+        }
+
+        bool readInt(int &out) {
+            double value;
+            if (!readNumber(value))
+                return false;
+            out = static_cast<int>(value);
+            return true;
+        }
+
+        bool readSize(size_t &out) {
+            double value;
+            if (!readNumber(value))
+                return false;
+            out = static_cast<size_t>(value);
+            return true;
+        }
+
+        bool readBool(bool &out) {
+            skipWhitespace();
+            if (end - cur >= 4 && memcmp(cur, "true", 4) == 0) {
+                cur += 4;
+                out = true;
+                return true;
+            }
+            if (end - cur >= 5 && memcmp(cur, "false", 5) == 0) {
+                cur += 5;
+                out = false;
+                return true;
+            }
+            fail("expected boolean");
+            return false;
+        }
+
+        void skipValue() {
+            const char c = peek();
+            if (c == '"') {
+                skipString();
+                return;
+            }
+
+            if (c == '{' || c == '[') {
+                int depth = 0;
+                while (cur < end) {
+                    const char d = *cur;
+                    if (d == '"') {
+                        skipString();
+                        continue;
+                    }
+                    ++cur;
+                    if (d == '{' || d == '[') {
+                        depth++;
+                    } else if (d == '}' || d == ']') {
+                        if (--depth == 0)
+                            return;
+                    }
+                }
+                fail("unterminated container");
+                return;
+            }
+
+            // Number, boolean or null
+            while (cur < end && *cur != ',' && *cur != '}' && *cur != ']' && *cur != ' ' && *cur != '\n' &&
+                   *cur != '\r' && *cur != '\t')
+                ++cur;
+        }
+    };
+
+    bool readIntArray(JsonReader &reader, std::vector<int> &out) {
+        out.clear();
+        if (!reader.beginArray())
+            return false;
+        while (reader.nextElement()) {
+            int value;
+            if (!reader.readInt(value))
+                return false;
+            out.push_back(value);
+        }
+        return !reader.failed();
+    }
+
+    bool readDoubleArray(JsonReader &reader, std::vector<double> &out) {
+        out.clear();
+        if (!reader.beginArray())
+            return false;
+        while (reader.nextElement()) {
+            double value;
+            if (!reader.readNumber(value))
+                return false;
+            out.push_back(value);
+        }
+        return !reader.failed();
+    }
+
+    // Same rules as tinygltf's ParseParameterProperty, used to keep Material::values/additionalValues filled
+    void readParameter(JsonReader &reader, tinygltf::Parameter &parameter) {
+        switch (reader.peek()) {
+            case '"':
+                reader.readString(parameter.string_value);
+                break;
+            case '[':
+                readDoubleArray(reader, parameter.number_array);
+                break;
+            case '{': {
+                reader.beginObject();
+                std::string_view key;
+                while (reader.nextMember(key)) {
+                    const std::string name(key);
+                    const char c = reader.peek();
+                    if (c == '-' || (c >= '0' && c <= '9')) {
+                        double value;
+                        reader.readNumber(value);
+                        parameter.json_double_value[name] = value;
+                    } else {
+                        reader.skipValue();
+                    }
+                }
+                break;
+            }
+            case 't':
+            case 'f':
+                reader.readBool(parameter.bool_value);
+                break;
+            default:
+                parameter.has_number_value = reader.readNumber(parameter.number_value);
+        }
+    }
+
+    void readAsset(JsonReader &reader, tinygltf::Asset &asset) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "version") reader.readString(asset.version);
+            else if (key == "generator") reader.readString(asset.generator);
+            else if (key == "minVersion") reader.readString(asset.minVersion);
+            else if (key == "copyright") reader.readString(asset.copyright);
+            else reader.skipValue();
+        }
+    }
+
+    int accessorType(const std::string_view type) {
+        if (type == "SCALAR") return TINYGLTF_TYPE_SCALAR;
+        if (type == "VEC2") return TINYGLTF_TYPE_VEC2;
+        if (type == "VEC3") return TINYGLTF_TYPE_VEC3;
+        if (type == "VEC4") return TINYGLTF_TYPE_VEC4;
+        if (type == "MAT2") return TINYGLTF_TYPE_MAT2;
+        if (type == "MAT3") return TINYGLTF_TYPE_MAT3;
+        if (type == "MAT4") return TINYGLTF_TYPE_MAT4;
+        return -1;
+    }
+
+    void readAccessor(JsonReader &reader, tinygltf::Accessor &accessor) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "bufferView") reader.readInt(accessor.bufferView);
+            else if (key == "byteOffset") reader.readSize(accessor.byteOffset);
+            else if (key == "componentType") reader.readInt(accessor.componentType);
+            else if (key == "normalized") reader.readBool(accessor.normalized);
+            else if (key == "count") reader.readSize(accessor.count);
+            else if (key == "min") readDoubleArray(reader, accessor.minValues);
+            else if (key == "max") readDoubleArray(reader, accessor.maxValues);
+            else if (key == "name") reader.readString(accessor.name);
+            else if (key == "type") {
+                std::string_view type;
+                if (reader.readString(type))
+                    accessor.type = accessorType(type);
+            } else if (key == "sparse") reader.fail("sparse accessors are not supported");
+            else reader.skipValue();
+        }
+    }
+
+    void readBufferView(JsonReader &reader, tinygltf::BufferView &bufferView) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "buffer") reader.readInt(bufferView.buffer);
+            else if (key == "byteOffset") reader.readSize(bufferView.byteOffset);
+            else if (key == "byteLength") reader.readSize(bufferView.byteLength);
+            else if (key == "byteStride") reader.readSize(bufferView.byteStride);
+            else if (key == "target") reader.readInt(bufferView.target);
+            else if (key == "name") reader.readString(bufferView.name);
+            else reader.skipValue();
+        }
+    }
+
+    void readBuffer(JsonReader &reader, tinygltf::Buffer &buffer, size_t &byteLength) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "uri") reader.readString(buffer.uri);
+            else if (key == "byteLength") reader.readSize(byteLength);
+            else if (key == "name") reader.readString(buffer.name);
+            else reader.skipValue();
+        }
+    }
+
+    void readNode(JsonReader &reader, tinygltf::Node &node) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "name") reader.readString(node.name);
+            else if (key == "mesh") reader.readInt(node.mesh);
+            else if (key == "skin") reader.readInt(node.skin);
+            else if (key == "camera") reader.readInt(node.camera);
+            else if (key == "children") readIntArray(reader, node.children);
+            else if (key == "matrix") readDoubleArray(reader, node.matrix);
+            else if (key == "translation") readDoubleArray(reader, node.translation);
+            else if (key == "rotation") readDoubleArray(reader, node.rotation);
+            else if (key == "scale") readDoubleArray(reader, node.scale);
+            else if (key == "weights") readDoubleArray(reader, node.weights);
+            else reader.skipValue();
+        }
+    }
+
+    void readPrimitive(JsonReader &reader, tinygltf::Primitive &primitive) {
+        primitive.mode = TINYGLTF_MODE_TRIANGLES;
+
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "attributes") {
+                reader.beginObject();
+                std::string_view attribute;
+                while (reader.nextMember(attribute)) {
+                    const std::string name(attribute);
+                    reader.readInt(primitive.attributes[name]);
+                }
+            } else if (key == "indices") reader.readInt(primitive.indices);
+            else if (key == "material") reader.readInt(primitive.material);
+            else if (key == "mode") reader.readInt(primitive.mode);
+            else reader.skipValue(); // Morph targets are not used by GltfObject
+        }
+    }
+
+    void readMesh(JsonReader &reader, tinygltf::Mesh &mesh) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "name") reader.readString(mesh.name);
+            else if (key == "weights") readDoubleArray(reader, mesh.weights);
+            else if (key == "primitives") {
+                reader.beginArray();
+                while (reader.nextElement())
+                    readPrimitive(reader, mesh.primitives.emplace_back());
+            } else reader.skipValue();
+        }
+    }
+
+    void readTextureInfo(JsonReader &reader, tinygltf::Parameter &parameter, int &index, int &texCoord) {
+        readParameter(reader, parameter);
+        index = parameter.TextureIndex();
+        texCoord = parameter.TextureTexCoord();
+    }
+
+    void readPbrMetallicRoughness(JsonReader &reader, tinygltf::Material &material) {
+        auto &pbr = material.pbrMetallicRoughness;
+
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "extensions" || key == "extras") {
+                reader.skipValue();
+                continue;
+            }
+
+            tinygltf::Parameter &parameter = material.values[std::string(key)];
+            if (key == "baseColorFactor") {
+                readParameter(reader, parameter);
+                if (parameter.number_array.size() == 4)
+                    pbr.baseColorFactor = parameter.number_array;
+            } else if (key == "baseColorTexture") {
+                readTextureInfo(reader, parameter, pbr.baseColorTexture.index, pbr.baseColorTexture.texCoord);
+            } else if (key == "metallicRoughnessTexture") {
+                readTextureInfo(reader, parameter, pbr.metallicRoughnessTexture.index,
+                                pbr.metallicRoughnessTexture.texCoord);
+            } else if (key == "metallicFactor") {
+                readParameter(reader, parameter);
+                pbr.metallicFactor = parameter.number_value;
+            } else if (key == "roughnessFactor") {
+                readParameter(reader, parameter);
+                pbr.roughnessFactor = parameter.number_value;
+            } else {
+                readParameter(reader, parameter);
+            }
+        }
+    }
+
+    void readMaterial(JsonReader &reader, tinygltf::Material &material) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "name") {
+                reader.readString(material.name);
+                continue;
+            }
+            if (key == "pbrMetallicRoughness") {
+                readPbrMetallicRoughness(reader, material);
+                continue;
+            }
+            // Vendor extensions (KHR_materials_specular, KHR_materials_ior...) are not used by the renderer
+            if (key == "extensions" || key == "extras") {
+                reader.skipValue();
+                continue;
+            }
+
+            const std::string name(key);
+            tinygltf::Parameter &parameter = material.additionalValues[name];
+            if (name == "emissiveTexture") {
+                readTextureInfo(reader, parameter, material.emissiveTexture.index, material.emissiveTexture.texCoord);
+            } else if (name == "normalTexture") {
+                readTextureInfo(reader, parameter, material.normalTexture.index, material.normalTexture.texCoord);
+                material.normalTexture.scale = parameter.TextureScale();
+            } else if (name == "occlusionTexture") {
+                readTextureInfo(reader, parameter, material.occlusionTexture.index,
+                                material.occlusionTexture.texCoord);
+                material.occlusionTexture.strength = parameter.TextureStrength();
+            } else {
+                readParameter(reader, parameter);
+                if (name == "emissiveFactor" && parameter.number_array.size() == 3)
+                    material.emissiveFactor = parameter.number_array;
+                else if (name == "alphaMode")
+                    material.alphaMode = parameter.string_value;
+                else if (name == "alphaCutoff")
+                    material.alphaCutoff = parameter.number_value;
+                else if (name == "doubleSided")
+                    material.doubleSided = parameter.bool_value;
+            }
+        }
+    }
+
+    void readTexture(JsonReader &reader, tinygltf::Texture &texture) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "sampler") reader.readInt(texture.sampler);
+            else if (key == "source") reader.readInt(texture.source);
+            else if (key == "name") reader.readString(texture.name);
+            else reader.skipValue();
+        }
+    }
+
+    void readImage(JsonReader &reader, tinygltf::Image &image) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "uri") reader.readString(image.uri);
+            else if (key == "mimeType") reader.readString(image.mimeType);
+            else if (key == "bufferView") reader.readInt(image.bufferView);
+            else if (key == "name") reader.readString(image.name);
+            else reader.skipValue();
+        }
+    }
+
+    void readSampler(JsonReader &reader, tinygltf::Sampler &sampler) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "magFilter") reader.readInt(sampler.magFilter);
+            else if (key == "minFilter") reader.readInt(sampler.minFilter);
+            else if (key == "wrapS") reader.readInt(sampler.wrapS);
+            else if (key == "wrapT") reader.readInt(sampler.wrapT);
+            else if (key == "name") reader.readString(sampler.name);
+            else reader.skipValue();
+        }
+    }
+
+    void readSkin(JsonReader &reader, tinygltf::Skin &skin) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "inverseBindMatrices") reader.readInt(skin.inverseBindMatrices);
+            else if (key == "skeleton") reader.readInt(skin.skeleton);
+            else if (key == "joints") readIntArray(reader, skin.joints);
+            else if (key == "name") reader.readString(skin.name);
+            else reader.skipValue();
+        }
+    }
+
+    void readAnimationChannel(JsonReader &reader, tinygltf::AnimationChannel &channel) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "sampler") {
+                reader.readInt(channel.sampler);
+            } else if (key == "target") {
+                reader.beginObject();
+                std::string_view targetKey;
+                while (reader.nextMember(targetKey)) {
+                    if (targetKey == "node") reader.readInt(channel.target_node);
+                    else if (targetKey == "path") reader.readString(channel.target_path);
+                    else reader.skipValue();
+                }
+            } else reader.skipValue();
+        }
+    }
+
+    void readAnimationSampler(JsonReader &reader, tinygltf::AnimationSampler &sampler) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "input") reader.readInt(sampler.input);
+            else if (key == "output") reader.readInt(sampler.output);
+            else if (key == "interpolation") reader.readString(sampler.interpolation);
+            else reader.skipValue();
+        }
+    }
+
+    void readAnimation(JsonReader &reader, tinygltf::Animation &animation) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "name") {
+                reader.readString(animation.name);
+            } else if (key == "channels") {
+                reader.beginArray();
+                while (reader.nextElement())
+                    readAnimationChannel(reader, animation.channels.emplace_back());
+            } else if (key == "samplers") {
+                reader.beginArray();
+                while (reader.nextElement())
+                    readAnimationSampler(reader, animation.samplers.emplace_back());
+            } else reader.skipValue();
+        }
+    }
+
+    void readScene(JsonReader &reader, tinygltf::Scene &scene) {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextMember(key)) {
+            if (key == "name") reader.readString(scene.name);
+            else if (key == "nodes") readIntArray(reader, scene.nodes);
+            else reader.skipValue();
+        }
+    }
+
+    void readStringArray(JsonReader &reader, std::vector<std::string> &out) {
+        reader.beginArray();
+        while (reader.nextElement())
+            reader.readString(out.emplace_back());
+    }
+
+    template<typename T, typename ReadElement>
+    void readArray(JsonReader &reader, std::vector<T> &out, ReadElement readElement) {
+        reader.beginArray();
+        while (reader.nextElement())
+            readElement(reader, out.emplace_back());
+    }
+
+    bool readWholeFile(const std::string &path, std::vector<unsigned char> &out) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            return false;
+        const std::streamsize size = file.tellg();
+        file.seekg(0, std::ios::beg);
+        out.resize(static_cast<size_t>(size));
+        return static_cast<bool>(file.read(reinterpret_cast<char *>(out.data()), size));
+    }
+
+    std::string decodeUri(const std::string &uri) {
+        std::string decoded;
+        decoded.reserve(uri.size());
+        for (size_t i = 0; i < uri.size(); i++) {
+            unsigned int value;
+            if (uri[i] == '%' && i + 2 < uri.size() &&
+                std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16).ptr == uri.data() + i + 3) {
+                decoded += static_cast<char>(value);
+                i += 2;
+            } else {
+                decoded += uri[i];
+            }
+        }
+        return decoded;
+    }
+
+    std::string baseDirectory(const std::string &filename) {
+        const size_t slash = filename.find_last_of("/\\");
+        return slash == std::string::npos ? std::string() : filename.substr(0, slash + 1);
+    }
+}
+
+bool GltfFastLoader::loadASCIIFromFile(tinygltf::Model &model, std::string &err, std::string &warn,
+                                       const std::string &filename, const bool loadImages, Stats *stats) {
+    Stats localStats;
+    Stats &timings = stats ? *stats : localStats;
+
+    auto start = Clock::now();
+
+    std::vector<unsigned char> json;
+    if (!readWholeFile(filename, json)) {
+        err += "File not found: " + filename + "\n";
+        return false;
+    }
+    timings.jsonBytes = json.size();
+
+    model = tinygltf::Model();
+    std::vector<size_t> bufferLengths;
+
+    JsonReader reader(reinterpret_cast<const char *>(json.data()), reinterpret_cast<const char *>(json.data()) + json.size());
+    reader.beginObject();
+    std::string_view key;
+    while (reader.nextMember(key)) {
+        if (key == "asset") readAsset(reader, model.asset);
+        else if (key == "scene") reader.readInt(model.defaultScene);
+        else if (key == "scenes") readArray(reader, model.scenes, readScene);
+        else if (key == "nodes") readArray(reader, model.nodes, readNode);
+        else if (key == "meshes") readArray(reader, model.meshes, readMesh);
+        else if (key == "accessors") readArray(reader, model.accessors, readAccessor);
+        else if (key == "bufferViews") readArray(reader, model.bufferViews, readBufferView);
+        else if (key == "materials") readArray(reader, model.materials, readMaterial);
+        else if (key == "textures") readArray(reader, model.textures, readTexture);
+        else if (key == "images") readArray(reader, model.images, readImage);
+        else if (key == "samplers") readArray(reader, model.samplers, readSampler);
+        else if (key == "skins") readArray(reader, model.skins, readSkin);
+        else if (key == "animations") readArray(reader, model.animations, readAnimation);
+        else if (key == "extensionsUsed") readStringArray(reader, model.extensionsUsed);
+        else if (key == "extensionsRequired") readStringArray(reader, model.extensionsRequired);
+        else if (key == "buffers") {
+            reader.beginArray();
+            while (reader.nextElement())
+                readBuffer(reader, model.buffers.emplace_back(), bufferLengths.emplace_back());
+        } else reader.skipValue();
+    }
+
+    if (reader.failed()) {
+        err += "Fast glTF parser: " + reader.getMessage() + "\n";
+        return false;
+    }
+    timings.jsonMs = elapsedMs(start);
+
+    // Binary buffers
+    start = Clock::now();
+    const std::string baseDir = baseDirectory(filename);
+    for (size_t i = 0; i < model.buffers.size(); i++) {
+        tinygltf::Buffer &buffer = model.buffers[i];
+        if (buffer.uri.empty() || buffer.uri.rfind("data:", 0) == 0) {
+            err += "Fast glTF parser: embedded buffer[" + std::to_string(i) + "] is not supported\n";
+            return false;
+        }
+
+        const std::string path = baseDir + decodeUri(buffer.uri);
+        if (!readWholeFile(path, buffer.data)) {
+            err += "File not found : " + buffer.uri + "\n";
+            return false;
+        }
+        if (buffer.data.size() < bufferLengths[i]) {
+            err += "File size mismatch : " + path + ", requestedBytes " + std::to_string(bufferLengths[i]) +
+                    ", but got " + std::to_string(buffer.data.size()) + "\n";
+            return false;
+        }
+        buffer.data.resize(bufferLengths[i]);
+    }
+    timings.buffersMs = elapsedMs(start);
+
+    // Images, decoded with the same stb_image settings as tinygltf (forced to 4 channels)
+    start = Clock::now();
+    std::vector<unsigned char> bytes;
+    for (size_t i = 0; i < model.images.size() && loadImages; i++) {
+        tinygltf::Image &image = model.images[i];
+
+        const unsigned char *data;
+        size_t size;
+        if (!image.uri.empty()) {
+            if (image.uri.rfind("data:", 0) == 0) {
+                err += "Fast glTF parser: embedded image[" + std::to_string(i) + "] is not supported\n";
+                return false;
+            }
+            if (!readWholeFile(baseDir + decodeUri(image.uri), bytes)) {
+                warn += "File not found : " + image.uri + "\n";
+                continue;
+            }
+            data = bytes.data();
+            size = bytes.size();
+        } else if (image.bufferView >= 0 && image.bufferView < static_cast<int>(model.bufferViews.size())) {
+            const tinygltf::BufferView &bufferView = model.bufferViews[image.bufferView];
+            if (bufferView.buffer < 0 || bufferView.buffer >= static_cast<int>(model.buffers.size()) ||
+                bufferView.byteOffset > model.buffers[bufferView.buffer].data.size() ||
+                bufferView.byteLength > model.buffers[bufferView.buffer].data.size() - bufferView.byteOffset) {
+                err += "Image[" + std::to_string(i) + "] bufferView " + std::to_string(image.bufferView) +
+                        " is outside of its buffer\n";
+                return false;
+            }
+            data = model.buffers[bufferView.buffer].data.data() + bufferView.byteOffset;
+            size = bufferView.byteLength;
+        } else {
+            warn += "Image[" + std::to_string(i) + "] has neither uri nor bufferView\n";
+            continue;
+        }
+
+        if (!tinygltf::LoadImageData(&image, static_cast<int>(i), &err, &warn, 0, 0, data, static_cast<int>(size),
+                                     nullptr)) {
+            return false;
+        }
+    }
+    timings.imagesMs = elapsedMs(start);
+
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef GLTFFASTLOADER_H
+#define GLTFFASTLOADER_H
+#include <string>
+#include <tiny_gltf.h>
+
+// Streaming glTF loader: reads the JSON once, front to back, and fills the tinygltf::Model directly
+// without building an intermediate DOM. Only the parts of the format used by GltfObject are kept;
+// extensions and extras are skipped without being parsed.
+class GltfFastLoader {
+    public:
+        struct Stats {
+            size_t jsonBytes = 0;
+            double jsonMs = 0.0;
+            double buffersMs = 0.0;
+            double imagesMs = 0.0;
+        };
+
+        // Returns false when the file can not be read or uses something the fast path does not handle
+        // (binary glTF, data URIs, sparse accessors...). In that case `err` says why and the caller
+        // is expected to fall back to tinygltf::TinyGLTF.
+        static bool loadASCIIFromFile(tinygltf::Model &model, std::string &err, std::string &warn,
+                                      const std::string &filename, bool loadImages = true, Stats *stats = nullptr);
+};
+
+#endif //GLTFFASTLOADER_H
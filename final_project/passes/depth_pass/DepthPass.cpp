@@ -5,74 +5,493 @@
 #include "DepthPass.h"
 
 #include <render/shader.h>
+#include <render/DrawDataRing.h>
+#include <render/ProgramUniforms.h>
+#include <render/UniformBlocks.h>
+#include <render/Frustum.h>
+#include <render/WorkerPool.h>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <view_points/lights/directional_light/DirectionalLight.h>
 
-DepthPass::DepthPass(const int width, const int height, std::vector<Light *> &lights) : RenderPass(width, height,
-        LoadShadersFromFile("../final_project/shaders/depth.vert", "../final_project/shaders/depth.frag")),
-    lights(lights) {
+static const UniformName FIRST_INSTANCE("firstInstance");
+
+DepthPass::DepthPass(const int width, const int height, std::vector<Light *> &lights, FrameUniforms &frameUniforms) :
+    RenderPass(width, height,
+               LoadShadersFromFile("../final_project/shaders/depth.vert", "../final_project/shaders/depth.frag")),
+    lights(lights), frameUniforms(frameUniforms) {
+    instancedProgram = LoadShadersFromFile("../final_project/shaders/depth_instanced.vert",
+                                           "../final_project/shaders/depth.frag");
 }
 
-void DepthPass::createDepthTextureArray() {
-    glBindFramebuffer(GL_FRAMEBUFFER, getFBO());
+static void attachDepth(const GLuint fbo, const GLuint texture) {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+    // Depth only, also a valid blit source
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Shadow atlas Framebuffer not complete!" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
 
-    // Create an array of texture for each lights
-    glGenTextures(1, &depthTexturesArray);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexturesArray);
+void DepthPass::addViews(const int light, const glm::ivec4 &tile) {
+    ShadowView view;
+    view.light = light;
 
-    // Allocation of memory for the array of depth textures
-    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32, getWidth(), getHeight(), static_cast<int>(lights.size()),
-                 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    if (lights[light]->getType() == SPOT_LIGHT) {
+        // The light's matrices are already in the ViewUniforms block
+        view.uniformView = FrameUniforms::getLightView(light);
+        view.viewProjection = view.cullMatrix = lights[light]->getVPMatrix();
+        view.viewport = tile;
+        view.depthRange = glm::vec2(lights[light]->getNear(), lights[light]->getFar());
+        views.push_back(view);
+        return;
+    }
 
-    // Setting up the array
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    if (lights[light]->getType() == POINT_LIGHT) {
+        // Hemispheres in the halves of the tile, each culled against the half of the range's cube in front of it
+        const float range = lights[light]->getRange();
+        const glm::mat4 bounds = glm::ortho(-range, range, -range, range, 0.0f, range);
+        view.uniformView = FrameUniforms::getLightView(light);
+        view.paraboloid = true;
+        view.depthRange = glm::vec2(POINT_SHADOW_NEAR, range);
+        for (int h = 0; h < 2; h++) {
+            view.index = h;
+            view.viewProjection = lights[light]->getParaboloidView(h);
+            view.cullMatrix = bounds * view.viewProjection;
+            view.viewport = ShadowAtlas::getHalf(tile, h);
+            views.push_back(view);
+        }
+        return;
+    }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // Cascades in the quadrants of the tile, where they would be once committed
+    const auto *directional = static_cast<const DirectionalLight *>(lights[light]);
+    view.orthographic = true;
+    for (int c = 0; c < CSM_CASCADES; c++) {
+        view.index = c;
+        view.uniformView = frameUniforms.getCascadeView(c);
+        view.viewProjection = view.cullMatrix = directional->getTargetMatrix(c);
+        view.viewport = ShadowAtlas::getQuadrant(tile, c);
+        views.push_back(view);
+    }
 }
 
-void DepthPass::render(const std::vector<GraphicsObject *> &objects, const Camera &camera) {
-    glBindFramebuffer(GL_FRAMEBUFFER, getFBO());
-    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+void DepthPass::cullViews(const int first, const int last) {
+    for (int v = first; v <= last; v++) {
+        ShadowView &view = views[v];
+        view.slots.assign(casters.size(), -1);
+        view.parts.clear();
+
+        for (int c = 0; c < casters.size(); c++) {
+            const GraphicsObject &caster = *casters[c];
+            const Frustum frustum(view.cullMatrix * casterMatrices[c]);
+            glm::vec3 min, max;
+            if (caster.getBounds(min, max) && !frustum.intersects(min, max))
+                continue;
+
+            // Unbounded parts are always drawn
+            const int partCount = caster.getPartCount();
+            std::vector<bool> parts(partCount);
+            int visibleParts = 0;
+            for (int p = 0; p < partCount; p++) {
+                parts[p] = !caster.getPartBounds(p, min, max) || frustum.intersects(min, max);
+                visibleParts += parts[p];
+            }
+            if (partCount > 0 && visibleParts == 0)
+                continue;
+            if (visibleParts == partCount)
+                parts.clear();
+
+            view.slots[c] = static_cast<int>(view.parts.size());
+            view.parts.push_back(std::move(parts));
+        }
+    }
+}
+
+bool DepthPass::hasDynamicCasters(const int first, const int last) const {
+    for (int v = first; v <= last; v++) {
+        for (int c = 0; c < casters.size(); c++) {
+            if (!casters[c]->isStatic() && views[v].slots[c] >= 0)
+                return true;
+        }
+    }
+    return false;
+}
+
+void DepthPass::drawCasters(const bool staticCasters, const std::vector<int> &viewIndices) {
+    if (viewIndices.empty())
+        return;
+    if (submission == ShadowSubmission::PER_VIEW || !drawInstanced(staticCasters, viewIndices))
+        drawPerView(staticCasters, viewIndices);
+}
+
+void DepthPass::drawPerView(const bool staticCasters, const std::vector<int> &viewIndices) {
+    glUseProgram(getShaderID());
+    const auto paraboloidView = ProgramUniforms::get(getShaderID()).uniform<glm::mat4>("paraboloidView");
+    const auto paraboloid = ProgramUniforms::get(getShaderID()).uniform<glm::vec3>("paraboloid");
+    glEnable(GL_CLIP_DISTANCE0);
+
+    for (const int v: viewIndices) {
+        const ShadowView &view = views[v];
+        frameUniforms.bindView(view.uniformView);
+        paraboloidView.set(view.viewProjection);
+        paraboloid.set(glm::vec3(view.paraboloid ? 1.0f : 0.0f, view.depthRange));
+        glViewport(view.viewport.x, view.viewport.y, view.viewport.z, view.viewport.w);
+        glScissor(view.viewport.x, view.viewport.y, view.viewport.z, view.viewport.w);
+
+        for (int c = 0; c < casters.size(); c++) {
+            if (casters[c]->isStatic() == staticCasters && view.slots[c] >= 0)
+                casters[c]->renderDepth(getShaderID(), 1, view.parts[view.slots[c]]);
+        }
+    }
+    glDisable(GL_CLIP_DISTANCE0);
+}
+
+bool DepthPass::drawInstanced(const bool staticCasters, const std::vector<int> &viewIndices) {
+    if (viewIndices.size() > MAX_SHADOW_VIEWS)
+        return false;
+
+    const auto atlasSize = static_cast<float>(SHADOW_ATLAS_SIZE);
+    for (int k = 0; k < viewIndices.size(); k++) {
+        const ShadowView &view = views[viewIndices[k]];
+        const glm::vec2 offset = glm::vec2(view.viewport.x, view.viewport.y);
+        const glm::vec2 size = glm::vec2(view.viewport.z, view.viewport.w);
+        shadowViewsData.viewProjections[k] = view.viewProjection;
+        shadowViewsData.viewports[k] = glm::vec4((offset + 0.5f * size) / atlasSize * 2.0f - 1.0f, size / atlasSize);
+        shadowViewsData.projections[k] = glm::vec4(view.paraboloid ? 1.0f : 0.0f, view.depthRange, 0.0f);
+    }
+
+    // Each caster's instances are a contiguous range of instanceViews, one per view it is in. Every instance draws
+    // the parts visible in any of those views, the clip distances drop the rest.
+    std::vector<int> firstInstances(casters.size());
+    std::vector<int> instanceCounts(casters.size(), 0);
+    std::vector<std::vector<bool> > casterParts(casters.size());
+    int instances = 0;
+    for (int c = 0; c < casters.size(); c++) {
+        if (casters[c]->isStatic() != staticCasters)
+            continue;
+        firstInstances[c] = instances;
+        bool allParts = false;
+        for (int k = 0; k < viewIndices.size(); k++) {
+            const ShadowView &view = views[viewIndices[k]];
+            if (view.slots[c] < 0)
+                continue;
+            if (instances == MAX_SHADOW_INSTANCES)
+                return false;
+            shadowViewsData.instanceViews[instances / 4][instances % 4] = k;
+            instances++;
+            instanceCounts[c]++;
+
+            const std::vector<bool> &parts = view.parts[view.slots[c]];
+            allParts = allParts || parts.empty();
+            if (allParts)
+                continue;
+            casterParts[c].resize(parts.size(), false);
+            for (size_t p = 0; p < parts.size(); p++)
+                casterParts[c][p] = casterParts[c][p] || parts[p];
+        }
+        if (allParts)
+            casterParts[c].clear();
+    }
+
+    // Orphan the previous contents, the other group of casters may still be reading them
+    glBindBuffer(GL_UNIFORM_BUFFER, shadowViewsUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(shadowViewsStruct), &shadowViewsData, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, SHADOW_VIEWS_BLOCK_BINDING, shadowViewsUBO);
+
+    // The whole atlas, the clip distances keep every instance inside its own tile and hemisphere
+    glViewport(0, 0, SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE);
+    glScissor(0, 0, SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE);
+    for (int i = 0; i < 5; i++)
+        glEnable(GL_CLIP_DISTANCE0 + i);
+
+    glUseProgram(instancedProgram);
+    const auto firstInstance = ProgramUniforms::get(instancedProgram).uniform<int>(FIRST_INSTANCE);
+    for (int c = 0; c < casters.size(); c++) {
+        if (instanceCounts[c] == 0)
+            continue;
+        firstInstance.set(firstInstances[c]);
+        casters[c]->renderDepth(instancedProgram, instanceCounts[c], casterParts[c]);
+    }
+
+    for (int i = 0; i < 5; i++)
+        glDisable(GL_CLIP_DISTANCE0 + i);
+    return true;
+}
+
+void DepthPass::schedule(const std::vector<GraphicsObject *> &objects, const Camera &camera, const float deltaTime) {
+    scheduled = true;
+    shadowAtlas.update(camera, lights, deltaTime);
+    frameUniforms.setShadowFilter(filtering == ShadowFiltering::EVSM, filter.getSoftness());
+
+    std::vector<GraphicsObject *> staticCasters;
+    std::vector<std::pair<GraphicsObject *, unsigned int> > staticScene;
+    for (const auto &object: objects) {
+        if (object->castsShadows() && object->isStatic()) {
+            staticCasters.push_back(object);
+            staticScene.emplace_back(object, object->getVersion());
+        }
+    }
+    // Any static object added, removed or moved invalidates every cache
+    if (staticScene != cachedStaticScene) {
+        cachedStaticScene = std::move(staticScene);
+        sceneVersion++;
+    }
+
+    // Static casters in the distance field are left out of the maps
+    const bool traced = staticShadows == StaticShadows::DISTANCE_FIELD;
+    if (traced && bakedSceneVersion != sceneVersion) {
+        distanceField.bake(staticCasters);
+        bakedSceneVersion = sceneVersion;
+    }
+    frameUniforms.setDistanceField(traced && distanceField.isBaked(), distanceField.getMin(), distanceField.getMax(),
+                                   distanceField.getVoxelSize(), distanceField.getSoftness());
 
-    glViewport(0, 0, getWidth(), getHeight());
+    casters.clear();
+    casterMatrices.clear();
+    for (const auto &object: objects) {
+        if (!object->castsShadows() || (traced && object->isStatic() && distanceField.isBaked(object)))
+            continue;
+        casters.push_back(object);
+        casterMatrices.push_back(object->getModelMatrix());
+    }
+
+    // Only the cascades of the first directional light are in the ViewUniforms block
+    const int cascadeLight = FrameUniforms::findCascadeLight(lights);
+    auto *directional = cascadeLight >= 0 ? static_cast<DirectionalLight *>(lights[cascadeLight]) : nullptr;
+    if (directional)
+        directional->updateCascades(camera);
 
+    // Views of every light with a tile, culled before deciding which to update
+    views.clear();
     for (int i = 0; i < lights.size(); i++) {
-        glm::mat4 lightModelMatrix = lights[i]->getVPMatrix();
+        const glm::ivec4 tile = shadowAtlas.getTile(i);
+        if (tile.z > 0 && (lights[i]->getType() != DIRECTIONAL_LIGHT || i == cascadeLight))
+            addViews(i, tile);
+    }
 
-        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexturesArray, 0, i);
-        glClear(GL_DEPTH_BUFFER_BIT);
+    // Each job owns a contiguous range of views, nothing else is written
+    const int viewCount = static_cast<int>(views.size());
+    WorkerPool &pool = WorkerPool::shared();
+    const int jobCount = viewCount * casters.size() < SHADOW_CULL_THREADED_TESTS ? 1 : pool.getThreadCount();
+    const int viewsPerJob = std::max((viewCount + jobCount - 1) / jobCount, 1);
+    pool.run((viewCount + viewsPerJob - 1) / viewsPerJob, [&](const int job) {
+        const int first = job * viewsPerJob;
+        cullViews(first, std::min(first + viewsPerJob, viewCount) - 1);
+    });
 
-        for (const auto &object: objects) {
-            glUseProgram(getShaderID());
+    // A view asks for an update when its cache is stale, or when dynamic casters are or were in it
+    std::vector<ShadowRequest> requests;
+    std::vector<int> requestViews;
+    std::vector<bool> staleRequests;
+    for (int v = 0; v < viewCount; v++) {
+        const ShadowView &view = views[v];
+        const Light &light = *lights[view.light];
+        const ShadowCache &cache = caches[{view.light, view.index}];
+        // Paraboloid views also depend on the range, which cullMatrix holds
+        const glm::mat4 lightingMatrix = view.orthographic
+                                             ? directional->getCascadeMatrix(view.index)
+                                             : view.cullMatrix;
+        const bool cached = cache.valid && cache.viewport == view.viewport && cache.sceneVersion == sceneVersion &&
+                            cache.viewProjection == lightingMatrix;
+        const bool refit = view.orthographic && !directional->isCascadeCurrent(view.index);
+        const bool dynamicCasters = hasDynamicCasters(v, v);
+        if (cached && !refit && !cache.composited && !dynamicCasters)
+            continue;
 
-            glm::mat4 mvp = lightModelMatrix * object->getModelMatrix();
-            glUniformMatrix4fv(glGetUniformLocation(getShaderID(), "mvp"), 1, GL_FALSE, &mvp[0][0]);
+        // A cascade whose slice is still inside it can wait for its refit, anything else stale cannot
+        const bool stale = !cached || refit;
+        const bool forced = !cached || (refit && !directional->coversSlice(view.index));
 
-            object->render(getShaderID());
+        // Share of the atlas, which already weighs the screen coverage and importance of the light. Nearer lights,
+        // nearer cascades and views with moving casters first.
+        float priority = static_cast<float>(view.viewport.z * view.viewport.w) /
+                         static_cast<float>(SHADOW_ATLAS_SIZE * SHADOW_ATLAS_SIZE);
+        if (view.orthographic)
+            priority /= static_cast<float>(1 << view.index);
+        else
+            priority /= 1.0f + glm::length(light.getPosition() - camera.getPosition()) / light.getRange();
+        if (dynamicCasters)
+            priority *= 2.0f;
+
+        size_t triangles = 0;
+        for (int c = 0; c < casters.size(); c++) {
+            if (view.slots[c] >= 0 && (stale || !casters[c]->isStatic()))
+                triangles += casters[c]->getDepthTriangles(view.parts[view.slots[c]]);
         }
+
+        requests.push_back({view.light, view.index, forced, priority, triangles});
+        requestViews.push_back(v);
+        staleRequests.push_back(stale);
     }
+
+    staleViews.clear();
+    updatedViews.clear();
+    scheduledTriangles = 0;
+    for (const int r: scheduler.schedule(requests)) {
+        const int v = requestViews[r];
+        ShadowView &view = views[v];
+        updatedViews.push_back(v);
+        if (staleRequests[r])
+            staleViews.push_back(v);
+        scheduledTriangles += requests[r].triangles;
+
+        // The cascade's matrices are uploaded after this, the lighting reads the map rendered with them
+        if (view.orthographic) {
+            directional->commitCascade(view.index);
+            view.viewProjection = view.cullMatrix = directional->getCascadeMatrix(view.index);
+        }
+
+        ShadowCache &cache = caches[{view.light, view.index}];
+        cache.valid = true;
+        cache.viewProjection = view.cullMatrix;
+        cache.sceneVersion = sceneVersion;
+        cache.viewport = view.viewport;
+        cache.composited = hasDynamicCasters(v, v);
+    }
+}
+
+void DepthPass::render(const std::vector<GraphicsObject *> &objects, const Camera &camera) {
+    // Without a schedule this frame, the cascades cannot move and the fades stand still
+    if (!scheduled)
+        schedule(objects, camera, 0.0f);
+    scheduled = false;
+    if (updatedViews.empty())
+        return;
+
+    scheduler.beginTiming(scheduledTriangles);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    // Clears and copies stay inside the tile being rendered
+    glEnable(GL_SCISSOR_TEST);
+
+    // Static casters of the stale views, into the cache
+    glBindFramebuffer(GL_FRAMEBUFFER, staticFBO);
+    for (const int v: staleViews) {
+        const glm::ivec4 &tile = views[v].viewport;
+        glScissor(tile.x, tile.y, tile.z, tile.w);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+    drawCasters(true, staleViews);
+
+    // Start from the static casters, the depth test keeps the nearest of both
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, staticFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, getFBO());
+    for (const int v: updatedViews) {
+        const glm::ivec4 &tile = views[v].viewport;
+        glScissor(tile.x, tile.y, tile.z, tile.w);
+        glBlitFramebuffer(tile.x, tile.y, tile.x + tile.z, tile.y + tile.w, tile.x, tile.y, tile.x + tile.z,
+                          tile.y + tile.w, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, getFBO());
+    drawCasters(false, updatedViews);
+
+    glDisable(GL_SCISSOR_TEST);
+    frameUniforms.bindView(0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    // The scheduler measures the cost per triangle, the filter's cost grows with the updated tiles' area instead
+    scheduler.endTiming();
+
+    if (filtering == ShadowFiltering::EVSM) {
+        std::vector<ShadowFilterView> filterViews;
+        for (const int v: updatedViews) {
+            const ShadowView &view = views[v];
+            const bool perspective = !view.orthographic && !view.paraboloid;
+            filterViews.push_back({view.viewport, perspective ? glm::vec3(1.0f, view.depthRange) : glm::vec3(0.0f)});
+        }
+        filter.filter(shadowAtlas.getTexture(), filterViews);
+    }
     glViewport(0, 0, 1024, 768);
 }
 
 void DepthPass::setup() {
-    createDepthTextureArray();
+    glUseProgram(getShaderID());
+    ProgramUniforms::get(getShaderID()).uniform<int>("drawData").set(DRAW_DATA_TEXTURE_UNIT);
+    glUseProgram(instancedProgram);
+    ProgramUniforms::get(instancedProgram).uniform<int>("drawData").set(DRAW_DATA_TEXTURE_UNIT);
+
+    glGenBuffers(1, &shadowViewsUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, shadowViewsUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(shadowViewsStruct), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    shadowAtlas.setup();
+    scheduler.setup();
+    filter.setup();
+    glGenFramebuffers(1, &staticFBO);
+    attachDepth(getFBO(), shadowAtlas.getTexture());
+    attachDepth(staticFBO, shadowAtlas.getStaticTexture());
 }
 
 void DepthPass::cleanup() {
-    if (depthTexturesArray != 0) {
-        glDeleteTextures(1, &depthTexturesArray);
-        depthTexturesArray = 0;
+    shadowAtlas.cleanup();
+    scheduler.cleanup();
+    filter.cleanup();
+    distanceField.cleanup();
+    if (staticFBO != 0) {
+        glDeleteFramebuffers(1, &staticFBO);
+        staticFBO = 0;
     }
-    if (lightsUBO != 0) {
-        glDeleteBuffers(1, &lightsUBO);
-        lightsUBO = 0;
+    if (shadowViewsUBO != 0) {
+        glDeleteBuffers(1, &shadowViewsUBO);
+        shadowViewsUBO = 0;
     }
+    glDeleteProgram(instancedProgram);
 }
 
-GLuint DepthPass::getDepthTexturesArray() const {
-    return depthTexturesArray;
+void DepthPass::setSubmission(const ShadowSubmission submission) {
+    this->submission = submission;
 }
 
+ShadowSubmission DepthPass::getSubmission() const {
+    return submission;
+}
+
+ShadowScheduler &DepthPass::getScheduler() {
+    return scheduler;
+}
+
+void DepthPass::setFiltering(const ShadowFiltering filtering) {
+    if (filtering != this->filtering)
+        caches.clear();
+    this->filtering = filtering;
+}
+
+ShadowFiltering DepthPass::getFiltering() const {
+    return filtering;
+}
+
+ShadowFilter &DepthPass::getFilter() {
+    return filter;
+}
+
+void DepthPass::setStaticShadows(const StaticShadows staticShadows) {
+    if (staticShadows != this->staticShadows)
+        caches.clear();
+    this->staticShadows = staticShadows;
+}
+
+StaticShadows DepthPass::getStaticShadows() const {
+    return staticShadows;
+}
+
+ShadowDistanceField &DepthPass::getDistanceField() {
+    return distanceField;
+}
+
+ShadowAtlas &DepthPass::getAtlas() {
+    return shadowAtlas;
+}
+
+GLuint DepthPass::getShadowAtlas() const {
+    return shadowAtlas.getTexture();
+}
+
+GLuint DepthPass::getShadowMoments() const {
+    return filter.getTexture();
+}
@@ -4,26 +4,170 @@
 
 #ifndef DEPTHPASS_H
 #define DEPTHPASS_H
+#include <map>
 #include <view_points/lights/light/Light.h>
 #include "passes/render_pass/RenderPass.h"
+#include "ShadowDistanceField.h"
+#include "ShadowFilter.h"
+#include "ShadowScheduler.h"
+#include "render/FrameUniforms.h"
+#include "render/ShadowAtlas.h"
+
+// Capacity of the ShadowViews block, mirrored in shaders/common/shadow_views.glsl
+#define MAX_SHADOW_VIEWS 64
+#define MAX_SHADOW_INSTANCES 1024
+
+// Below this many caster and view pairs the culling stays on the calling thread, waking the workers would cost more
+#define SHADOW_CULL_THREADED_TESTS 256
+
+// std140 layout of the ShadowViews block
+struct shadowViewsStruct {
+    glm::mat4 viewProjections[MAX_SHADOW_VIEWS];
+    // Center and half size of the view's tile, in normalized device coordinates of the atlas
+    glm::vec4 viewports[MAX_SHADOW_VIEWS];
+    // 1 and the light's depth range for paraboloid views
+    glm::vec4 projections[MAX_SHADOW_VIEWS];
+    // View of each instance, four per element
+    glm::ivec4 instanceViews[MAX_SHADOW_INSTANCES / 4];
+};
+
+// Static casters of a shadow view, rendered into the static atlas and copied under the dynamic casters when the
+// view is updated
+struct ShadowCache {
+    bool valid = false;
+    // The cache is stale once the lighting reads the view through another matrix
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    unsigned int sceneVersion = 0;
+    glm::ivec4 viewport = glm::ivec4(0);
+    // Whether the main atlas holds dynamic casters on top of the cache
+    bool composited = false;
+};
+
+// One shadow map that may be rendered this frame: a spotlight, one cascade of a directional light or one
+// hemisphere of a point light
+struct ShadowView {
+    int light = 0;
+    // Cascade of a directional light or hemisphere of a point light, 0 otherwise
+    int index = 0;
+    // View of the FrameUniforms views block
+    int uniformView = 0;
+    // The hemisphere's view matrix for paraboloid views
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    // Bounds of what the view can see, which casters are culled against
+    glm::mat4 cullMatrix = glm::mat4(1.0f);
+    // Texels of the atlas the view renders to
+    glm::ivec4 viewport = glm::ivec4(0);
+    bool orthographic = false;
+    bool paraboloid = false;
+    // Near and far distance of paraboloid and spotlight views
+    glm::vec2 depthRange = glm::vec2(0.0f);
+
+    // Casters in the view, found by cullViews: index in parts of each caster, -1 when it is culled
+    std::vector<int> slots;
+    // Parts each caster in the view draws, empty when it draws all of them
+    std::vector<std::vector<bool> > parts;
+};
+
+// How the casters are submitted to the shadow views
+enum class ShadowSubmission {
+    // One draw per caster and per view
+    PER_VIEW,
+    // One instanced draw per caster, each instance placed in its view's tile by the vertex shader
+    INSTANCED
+};
 
 class DepthPass : public RenderPass {
-    GLuint depthTexturesArray = 0;
-    GLuint lightsUBO = 0;
+    ShadowAtlas shadowAtlas;
+    GLuint staticFBO = 0;
+    // By light and view of the light
+    std::map<std::pair<int, int>, ShadowCache> caches;
     std::vector<Light *> &lights;
+    FrameUniforms &frameUniforms;
 
-public:
-    DepthPass(int width, int height, std::vector<Light *> &lights);
+    // Objects casting shadows this frame, and their model matrices
+    std::vector<GraphicsObject *> casters;
+    std::vector<glm::mat4> casterMatrices;
+    // Static objects and their versions when sceneVersion last changed
+    std::vector<std::pair<GraphicsObject *, unsigned int> > cachedStaticScene;
+    unsigned int sceneVersion = 0;
+
+    ShadowSubmission submission = ShadowSubmission::INSTANCED;
+    GLuint instancedProgram;
+    GLuint shadowViewsUBO = 0;
+    shadowViewsStruct shadowViewsData{};
+
+    ShadowScheduler scheduler;
+    ShadowFiltering filtering = ShadowFiltering::HARD;
+    ShadowFilter filter;
+    StaticShadows staticShadows = StaticShadows::SHADOW_MAPS;
+    ShadowDistanceField distanceField;
+    // sceneVersion the distance field was baked at
+    unsigned int bakedSceneVersion = 0;
+    bool scheduled = false;
+    // Triangles the scheduled views draw
+    size_t scheduledTriangles = 0;
+
+    std::vector<ShadowView> views;
+    std::vector<int> staleViews;
+    std::vector<int> updatedViews;
+
+    // Appends the views of a light, its cascades for a directional light
+    void addViews(int light, const glm::ivec4 &tile);
+
+    // Finds the casters of views first to last, and which of their parts they draw
+    void cullViews(int first, int last);
 
-    void createDepthTextureArray();
+    // Whether any dynamic caster is in views first to last
+    [[nodiscard]] bool hasDynamicCasters(int first, int last) const;
+
+    // Draws the static or the dynamic casters of the views
+    void drawCasters(bool staticCasters, const std::vector<int> &viewIndices);
+
+    void drawPerView(bool staticCasters, const std::vector<int> &viewIndices);
+
+    // False, without drawing anything, when the views or instances do not fit in the ShadowViews block
+    bool drawInstanced(bool staticCasters, const std::vector<int> &viewIndices);
+
+public:
+    DepthPass(int width, int height, std::vector<Light *> &lights, FrameUniforms &frameUniforms);
 
     void setup() override;
 
+    // Chooses the shadowed lights and the shadow views render() updates, and commits the cascades it refits. Runs
+    // every frame before FrameUniforms::update, which uploads the cascades. deltaTime drives the shadow fades.
+    void schedule(const std::vector<GraphicsObject *> &objects, const Camera &camera, float deltaTime);
+
     void render(const std::vector<GraphicsObject *> &objects, const Camera &camera) override;
 
     void cleanup() override;
 
-    [[nodiscard]] GLuint getDepthTexturesArray() const;
+    void setSubmission(ShadowSubmission submission);
+
+    [[nodiscard]] ShadowSubmission getSubmission() const;
+
+    [[nodiscard]] ShadowScheduler &getScheduler();
+
+    // Rerenders every view when the filtering changes, the moments of the views not updated since are missing
+    void setFiltering(ShadowFiltering filtering);
+
+    [[nodiscard]] ShadowFiltering getFiltering() const;
+
+    [[nodiscard]] ShadowFilter &getFilter();
+
+    // Rerenders every view when the static casters leave or join the maps. The distance field is baked on the
+    // next schedule, and again whenever a static object changes.
+    void setStaticShadows(StaticShadows staticShadows);
+
+    [[nodiscard]] StaticShadows getStaticShadows() const;
+
+    [[nodiscard]] ShadowDistanceField &getDistanceField();
+
+    [[nodiscard]] ShadowAtlas &getAtlas();
+
+    [[nodiscard]] GLuint getShadowAtlas() const;
+
+    // Filtered moments of the shadow atlas, 0 until the first frame with ShadowFiltering::EVSM
+    [[nodiscard]] GLuint getShadowMoments() const;
 };
 
 #endif //DEPTHPASS_H
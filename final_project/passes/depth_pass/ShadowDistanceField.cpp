@@ -0,0 +1,205 @@
+#include "ShadowDistanceField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Voxels around each triangle that get their exact distance to it
+static constexpr int EXACT_BAND = 2;
+
+// Point of the triangle abc nearest to p, by the Voronoi region of p
+static glm::vec3 closestPointOnTriangle(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &b,
+                                        const glm::vec3 &c) {
+    const glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    const float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+
+    const glm::vec3 bp = p - b;
+    const float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+
+    const glm::vec3 cp = p - c;
+    const float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / (d4 - d3 + d5 - d6));
+
+    // Degenerate triangles have no interior, their nearest edge point was returned above
+    const float denominator = va + vb + vc;
+    if (denominator <= 0.0f)
+        return a;
+    return a + ab * (vb / denominator) + ac * (vc / denominator);
+}
+
+bool ShadowDistanceField::bake(const std::vector<GraphicsObject *> &casters) {
+    std::vector<glm::vec3> corners;
+    bakedCasters.clear();
+    for (const GraphicsObject *caster: casters) {
+        const size_t first = corners.size();
+        if (!caster->getDepthGeometry(corners))
+            continue;
+        bakedCasters.push_back(caster);
+        const glm::mat4 model = caster->getModelMatrix();
+        for (size_t i = first; i < corners.size(); i++)
+            corners[i] = glm::vec3(model * glm::vec4(corners[i], 1.0f));
+    }
+    if (corners.empty())
+        return false;
+
+    glm::vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+    for (const glm::vec3 &corner: corners) {
+        min = glm::min(min, corner);
+        max = glm::max(max, corner);
+    }
+    const glm::vec3 extent = max - min;
+    voxelSize = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-3f)) /
+                (DISTANCE_FIELD_RESOLUTION - 2 * DISTANCE_FIELD_PADDING);
+    resolution = glm::ivec3(glm::ceil(extent / voxelSize)) + 2 * DISTANCE_FIELD_PADDING;
+    resolution = glm::clamp(resolution, glm::ivec3(1), glm::ivec3(DISTANCE_FIELD_RESOLUTION));
+    // Centered on the casters, the texture spans whole voxels
+    boundsMin = 0.5f * (min + max) - 0.5f * voxelSize * glm::vec3(resolution);
+    boundsMax = boundsMin + voxelSize * glm::vec3(resolution);
+
+    const size_t voxelCount = static_cast<size_t>(resolution.x) * resolution.y * resolution.z;
+    auto voxelIndex = [this](const int x, const int y, const int z) {
+        return (static_cast<size_t>(z) * resolution.y + y) * resolution.x + x;
+    };
+    auto voxelCenter = [this](const int x, const int y, const int z) {
+        return boundsMin + (glm::vec3(x, y, z) + 0.5f) * voxelSize;
+    };
+
+    // Nearest surface point found so far for each voxel, and its squared distance
+    std::vector<glm::vec3> nearest(voxelCount);
+    std::vector<float> distances(voxelCount, std::numeric_limits<float>::max());
+
+    for (size_t t = 0; t + 2 < corners.size(); t += 3) {
+        const glm::vec3 &a = corners[t], &b = corners[t + 1], &c = corners[t + 2];
+        const glm::vec3 triangleMin = glm::min(a, glm::min(b, c)), triangleMax = glm::max(a, glm::max(b, c));
+        const glm::ivec3 first = glm::max(glm::ivec3(glm::floor((triangleMin - boundsMin) / voxelSize)) - EXACT_BAND,
+                                          glm::ivec3(0));
+        const glm::ivec3 last = glm::min(glm::ivec3(glm::floor((triangleMax - boundsMin) / voxelSize)) + EXACT_BAND,
+                                         resolution - 1);
+        for (int z = first.z; z <= last.z; z++)
+            for (int y = first.y; y <= last.y; y++)
+                for (int x = first.x; x <= last.x; x++) {
+                    const glm::vec3 center = voxelCenter(x, y, z);
+                    const glm::vec3 point = closestPointOnTriangle(center, a, b, c);
+                    const float distance = glm::dot(center - point, center - point);
+                    const size_t i = voxelIndex(x, y, z);
+                    if (distance < distances[i]) {
+                        distances[i] = distance;
+                        nearest[i] = point;
+                    }
+                }
+    }
+
+    // The 13 neighbours before a voxel in raster order, and their offsets in the voxel array
+    glm::ivec3 neighbours[13];
+    long long neighbourOffsets[13];
+    for (int n = 0; n < 13; n++) {
+        neighbours[n] = glm::ivec3(n % 3 - 1, n / 3 % 3 - 1, n / 9 - 1);
+        neighbourOffsets[n] = (static_cast<long long>(neighbours[n].z) * resolution.y + neighbours[n].y) *
+                              resolution.x + neighbours[n].x;
+    }
+
+    // Each voxel tries the nearest points its neighbours already swept found, forwards then backwards
+    auto sweep = [&](const int direction) {
+        const glm::ivec3 start = direction > 0 ? glm::ivec3(0) : resolution - 1;
+        for (int z = start.z; z >= 0 && z < resolution.z; z += direction)
+            for (int y = start.y; y >= 0 && y < resolution.y; y += direction)
+                for (int x = start.x; x >= 0 && x < resolution.x; x += direction) {
+                    const glm::ivec3 voxel(x, y, z);
+                    const bool border = glm::any(glm::equal(voxel, glm::ivec3(0))) ||
+                                        glm::any(glm::equal(voxel, resolution - 1));
+                    const size_t i = voxelIndex(x, y, z);
+                    const glm::vec3 center = voxelCenter(x, y, z);
+                    for (int n = 0; n < 13; n++) {
+                        if (border) {
+                            const glm::ivec3 neighbour = voxel + neighbours[n] * direction;
+                            if (glm::any(glm::lessThan(neighbour, glm::ivec3(0))) ||
+                                glm::any(glm::greaterThanEqual(neighbour, resolution)))
+                                continue;
+                        }
+                        const size_t j = i + neighbourOffsets[n] * direction;
+                        if (distances[j] == std::numeric_limits<float>::max())
+                            continue;
+                        const glm::vec3 difference = center - nearest[j];
+                        const float distance = glm::dot(difference, difference);
+                        if (distance < distances[i]) {
+                            distances[i] = distance;
+                            nearest[i] = nearest[j];
+                        }
+                    }
+                }
+    };
+    sweep(1);
+    sweep(-1);
+    for (float &distance: distances)
+        distance = std::sqrt(distance);
+
+    if (texture == 0)
+        glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R16F, resolution.x, resolution.y, resolution.z, 0, GL_RED, GL_FLOAT,
+                 distances.data());
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    return true;
+}
+
+bool ShadowDistanceField::isBaked() const {
+    return !bakedCasters.empty();
+}
+
+bool ShadowDistanceField::isBaked(const GraphicsObject *caster) const {
+    return std::find(bakedCasters.begin(), bakedCasters.end(), caster) != bakedCasters.end();
+}
+
+glm::vec3 ShadowDistanceField::getMin() const {
+    return boundsMin;
+}
+
+glm::vec3 ShadowDistanceField::getMax() const {
+    return boundsMax;
+}
+
+float ShadowDistanceField::getVoxelSize() const {
+    return voxelSize;
+}
+
+void ShadowDistanceField::setSoftness(const float softness) {
+    this->softness = std::max(softness, 1e-3f);
+}
+
+float ShadowDistanceField::getSoftness() const {
+    return softness;
+}
+
+GLuint ShadowDistanceField::getTexture() const {
+    return texture;
+}
+
+void ShadowDistanceField::cleanup() {
+    if (texture != 0) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+    bakedCasters.clear();
+}
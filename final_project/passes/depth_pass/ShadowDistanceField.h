@@ -0,0 +1,65 @@
+#ifndef SHADOWDISTANCEFIELD_H
+#define SHADOWDISTANCEFIELD_H
+#include <vector>
+#include <glm/glm.hpp>
+#include "glad/gl.h"
+#include "3D_objects/graphics_object/GraphicsObject.h"
+
+#define DISTANCE_FIELD_TEXTURE_UNIT 18
+// Voxels along the longest side of the static casters' bounds
+#define DISTANCE_FIELD_RESOLUTION 128
+// Voxels of empty space around the bounds, so rays leaving the casters see their distance grow
+#define DISTANCE_FIELD_PADDING 2
+// Default width of the penumbra cone, as the distance it widens by per unit along the ray
+#define DISTANCE_FIELD_DEFAULT_SOFTNESS 0.05f
+
+// Where the static casters are shadowed from
+enum class StaticShadows {
+    // Rendered into the shadow maps with the dynamic casters
+    SHADOW_MAPS,
+    // Cone traced through ShadowDistanceField by the lighting, the maps only hold the dynamic casters
+    DISTANCE_FIELD
+};
+
+// Distance to the nearest static caster, baked on the CPU into a 3D texture over the casters' bounds. The depth
+// geometry of the casters, their shadow proxies, is voxelized: voxels near a triangle get their exact distance,
+// the others the distance to the nearest point their neighbours found, propagated in raster sweeps.
+//
+// Open surfaces such as the island's terrain and foliage cards have no inside, so the distances are unsigned and
+// the tracing in shaders/common/distance_field.glsl treats anything closer than DISTANCE_FIELD_HIT voxels as a hit.
+class ShadowDistanceField {
+    GLuint texture = 0;
+    glm::ivec3 resolution = glm::ivec3(0);
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    float voxelSize = 0.0f;
+    float softness = DISTANCE_FIELD_DEFAULT_SOFTNESS;
+    // Casters whose depth geometry is in the field
+    std::vector<const GraphicsObject *> bakedCasters;
+
+public:
+    // Replaces the field with one of the casters' world space depth geometry, false when none of them has any
+    bool bake(const std::vector<GraphicsObject *> &casters);
+
+    [[nodiscard]] bool isBaked() const;
+
+    // Whether the caster is in the field, casters without depth geometry on the CPU are not
+    [[nodiscard]] bool isBaked(const GraphicsObject *caster) const;
+
+    [[nodiscard]] glm::vec3 getMin() const;
+
+    [[nodiscard]] glm::vec3 getMax() const;
+
+    [[nodiscard]] float getVoxelSize() const;
+
+    void setSoftness(float softness);
+
+    [[nodiscard]] float getSoftness() const;
+
+    // 0 until the first bake
+    [[nodiscard]] GLuint getTexture() const;
+
+    void cleanup();
+};
+
+#endif //SHADOWDISTANCEFIELD_H
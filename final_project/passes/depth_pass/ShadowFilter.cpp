@@ -0,0 +1,130 @@
+#include "ShadowFilter.h"
+
+#include <algorithm>
+#include <iostream>
+#include <render/shader.h>
+#include <render/ProgramUniforms.h>
+#include <render/ShadowAtlas.h>
+
+#include "utils/renderQuad.h"
+
+void ShadowFilter::setup() {
+    program = LoadShadersFromFile("../final_project/shaders/ssao.vert", "../final_project/shaders/shadow_moments.frag");
+    glUseProgram(program);
+    ProgramUniforms::get(program).uniform<int>("source").set(0);
+}
+
+void ShadowFilter::createTextures() {
+    // Two moments of two warps, 16 bits are enough for the exponents of shaders/common/shadow_moments.glsl
+    glGenTextures(1, &moments);
+    glBindTexture(GL_TEXTURE_2D, moments);
+    for (int level = 0; level < SHADOW_MOMENT_LEVELS; level++)
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA16F, SHADOW_ATLAS_SIZE >> level, SHADOW_ATLAS_SIZE >> level, 0,
+                     GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, SHADOW_MOMENT_LEVELS - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenFramebuffers(SHADOW_MOMENT_LEVELS, levelFBOs);
+    for (int level = 0; level < SHADOW_MOMENT_LEVELS; level++) {
+        glBindFramebuffer(GL_FRAMEBUFFER, levelFBOs[level]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, moments, level);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Shadow moments Framebuffer not complete!" << std::endl;
+    }
+
+    glGenTextures(1, &scratch);
+    glBindTexture(GL_TEXTURE_2D, scratch);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SHADOW_TILE_MAX, SHADOW_TILE_MAX, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenFramebuffers(1, &scratchFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, scratchFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, scratch, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Shadow scratch Framebuffer not complete!" << std::endl;
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowFilter::filter(const GLuint depthTexture, const std::vector<ShadowFilterView> &views) {
+    if (views.empty())
+        return;
+    if (moments == 0)
+        createTextures();
+
+    glUseProgram(program);
+    ProgramUniforms &uniforms = ProgramUniforms::get(program);
+    const auto fromDepth = uniforms.uniform<int>("fromDepth");
+    const auto sourceRect = uniforms.uniform<glm::ivec4>("sourceRect");
+    const auto targetCorner = uniforms.uniform<glm::ivec2>("targetCorner");
+    const auto direction = uniforms.uniform<glm::ivec2>("direction");
+    const auto linearize = uniforms.uniform<glm::vec3>("linearize");
+    glActiveTexture(GL_TEXTURE0);
+
+    for (const ShadowFilterView &view: views) {
+        const glm::ivec4 &rect = view.viewport;
+
+        // Depths to moments, blurred along x into the scratch
+        glBindFramebuffer(GL_FRAMEBUFFER, scratchFBO);
+        glViewport(0, 0, rect.z, rect.w);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        fromDepth.set(1);
+        sourceRect.set(rect);
+        targetCorner.set(glm::ivec2(0));
+        direction.set(glm::ivec2(1, 0));
+        linearize.set(view.linearize);
+        renderQuad();
+
+        // Blurred along y into the view's texels of the moments
+        glBindFramebuffer(GL_FRAMEBUFFER, levelFBOs[0]);
+        glViewport(rect.x, rect.y, rect.z, rect.w);
+        glBindTexture(GL_TEXTURE_2D, scratch);
+        fromDepth.set(0);
+        sourceRect.set(glm::ivec4(0, 0, rect.z, rect.w));
+        targetCorner.set(glm::ivec2(rect.x, rect.y));
+        direction.set(glm::ivec2(0, 1));
+        renderQuad();
+
+        // Each texel of a level is the bilinear tap between four of the previous one
+        for (int level = 1; level < SHADOW_MOMENT_LEVELS; level++) {
+            const glm::ivec4 source = rect / (1 << (level - 1));
+            const glm::ivec4 target = rect / (1 << level);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, levelFBOs[level - 1]);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, levelFBOs[level]);
+            glBlitFramebuffer(source.x, source.y, source.x + source.z, source.y + source.w, target.x, target.y,
+                              target.x + target.z, target.y + target.w, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowFilter::setSoftness(const float level) {
+    softness = std::clamp(level, 0.0f, static_cast<float>(SHADOW_MOMENT_LEVELS - 1));
+}
+
+float ShadowFilter::getSoftness() const {
+    return softness;
+}
+
+GLuint ShadowFilter::getTexture() const {
+    return moments;
+}
+
+void ShadowFilter::cleanup() {
+    if (moments != 0) {
+        glDeleteFramebuffers(SHADOW_MOMENT_LEVELS, levelFBOs);
+        glDeleteFramebuffers(1, &scratchFBO);
+        glDeleteTextures(1, &moments);
+        glDeleteTextures(1, &scratch);
+        moments = 0;
+        scratch = 0;
+    }
+    glDeleteProgram(program);
+}
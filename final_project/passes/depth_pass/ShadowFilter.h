@@ -0,0 +1,63 @@
+#ifndef SHADOWFILTER_H
+#define SHADOWFILTER_H
+#include <vector>
+#include <glm/glm.hpp>
+#include "glad/gl.h"
+
+#define SHADOW_MOMENTS_TEXTURE_UNIT 15
+// Mip levels of the moments atlas. The quadrants of the smallest tiles are still 4 texels wide at the last one, and
+// every view stays aligned on whole texels at all of them.
+#define SHADOW_MOMENT_LEVELS 5
+// Default mip level the lighting reads, higher is softer
+#define SHADOW_DEFAULT_SOFTNESS 1.0f
+
+// How the lighting reads the shadow maps
+enum class ShadowFiltering {
+    // One depth comparison per light
+    HARD,
+    // One trilinear fetch of the blurred, mipmapped moments of the maps (shaders/common/shadow_moments.glsl)
+    EVSM
+};
+
+// A shadow view whose moments are rebuilt from the depth atlas
+struct ShadowFilterView {
+    // Texels of the atlas the view covers
+    glm::ivec4 viewport;
+    // 1 and the near and far planes of perspective views, whose depth is linearized first
+    glm::vec3 linearize;
+};
+
+// Turns the depth atlas into exponential variance moments in an atlas of the same layout, for the views updated
+// this frame only: the other views keep theirs, so static shadows are filtered once like they are rendered once.
+// Each view is blurred along x into a scratch texture, along y into the moments, then downsampled level by level
+// inside its own texels. The textures are only created on the first filtered frame.
+class ShadowFilter {
+    GLuint program = 0;
+    GLuint moments = 0;
+    // One per mip level of the moments
+    GLuint levelFBOs[SHADOW_MOMENT_LEVELS] = {};
+    // A view blurred along x, at most a tile large
+    GLuint scratch = 0;
+    GLuint scratchFBO = 0;
+
+    float softness = SHADOW_DEFAULT_SOFTNESS;
+
+    void createTextures();
+
+public:
+    void setup();
+
+    void filter(GLuint depthTexture, const std::vector<ShadowFilterView> &views);
+
+    // Mip level the lighting reads, clamped to the levels there are
+    void setSoftness(float level);
+
+    [[nodiscard]] float getSoftness() const;
+
+    // 0 until the first filtered frame
+    [[nodiscard]] GLuint getTexture() const;
+
+    void cleanup();
+};
+
+#endif //SHADOWFILTER_H
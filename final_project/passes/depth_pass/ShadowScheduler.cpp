@@ -0,0 +1,111 @@
+#include "ShadowScheduler.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+void ShadowScheduler::setup() {
+    glGenQueries(SHADOW_TIMER_QUERIES, queries);
+}
+
+std::vector<int> ShadowScheduler::schedule(const std::vector<ShadowRequest> &requests) {
+    readQueries();
+    frame++;
+
+    size_t budget = triangleBudget > 0 ? triangleBudget : std::numeric_limits<size_t>::max();
+    if (triangleBudget == 0 && timeBudget > 0.0f && nanosecondsPerTriangle > 0.0)
+        budget = static_cast<size_t>(timeBudget * 1e6 / nanosecondsPerTriangle);
+
+    // Views never rendered count as having waited the longest
+    std::vector<bool> urgent(requests.size());
+    std::vector<float> scores(requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        const auto last = lastUpdates.find({requests[i].light, requests[i].view});
+        const unsigned long waited = last != lastUpdates.end() ? frame - last->second : maxInterval;
+        urgent[i] = requests[i].forced || waited >= maxInterval;
+        scores[i] = requests[i].priority * static_cast<float>(waited);
+    }
+
+    std::vector<int> order(requests.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](const int a, const int b) {
+        return urgent[a] != urgent[b] ? urgent[a] : scores[a] > scores[b];
+    });
+
+    // The first request is always served, a budget below any single view still makes progress. Smaller requests
+    // may still fit after a larger one did not.
+    std::vector<int> served;
+    size_t used = 0;
+    for (const int i: order) {
+        if (!urgent[i] && !served.empty() && used + requests[i].triangles > budget)
+            continue;
+        used += requests[i].triangles;
+        lastUpdates[{requests[i].light, requests[i].view}] = frame;
+        served.push_back(i);
+    }
+    std::sort(served.begin(), served.end());
+    return served;
+}
+
+void ShadowScheduler::readQueries() {
+    for (int q = 0; q < SHADOW_TIMER_QUERIES; q++) {
+        if (!queryPending[q])
+            continue;
+        GLint available = 0;
+        glGetQueryObjectiv(queries[q], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries[q], GL_QUERY_RESULT, &nanoseconds);
+        queryPending[q] = false;
+        if (queryTriangles[q] == 0)
+            continue;
+
+        // Smoothed, a single frame says little
+        const double sample = static_cast<double>(nanoseconds) / static_cast<double>(queryTriangles[q]);
+        nanosecondsPerTriangle = nanosecondsPerTriangle > 0.0
+                                     ? 0.9 * nanosecondsPerTriangle + 0.1 * sample
+                                     : sample;
+    }
+}
+
+void ShadowScheduler::beginTiming(const size_t triangles) {
+    // Every query still in flight, this frame goes untimed
+    timing = !queryPending[query];
+    if (!timing)
+        return;
+    queryTriangles[query] = triangles;
+    glBeginQuery(GL_TIME_ELAPSED, queries[query]);
+}
+
+void ShadowScheduler::endTiming() {
+    if (!timing)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    queryPending[query] = true;
+    query = (query + 1) % SHADOW_TIMER_QUERIES;
+    timing = false;
+}
+
+void ShadowScheduler::setTriangleBudget(const size_t triangles) {
+    triangleBudget = triangles;
+}
+
+void ShadowScheduler::setTimeBudget(const float milliseconds) {
+    timeBudget = milliseconds;
+}
+
+void ShadowScheduler::setMaxInterval(const int frames) {
+    maxInterval = std::max(frames, 1);
+}
+
+double ShadowScheduler::getNanosecondsPerTriangle() const {
+    return nanosecondsPerTriangle;
+}
+
+void ShadowScheduler::cleanup() {
+    if (queries[0] != 0)
+        glDeleteQueries(SHADOW_TIMER_QUERIES, queries);
+    std::fill(std::begin(queries), std::end(queries), 0);
+}
@@ -0,0 +1,74 @@
+#ifndef SHADOWSCHEDULER_H
+#define SHADOWSCHEDULER_H
+#include <cstddef>
+#include <map>
+#include <vector>
+#include "glad/gl.h"
+
+// Default GPU time the shadow updates of a frame may take
+#define SHADOW_TIME_BUDGET_MS 2.0f
+// Frames a shadow view may wait before it is refreshed past the budget
+#define SHADOW_MAX_INTERVAL 8
+// Frames of GPU timings in flight, read back without waiting on the GPU
+#define SHADOW_TIMER_QUERIES 4
+
+// A shadow view asking to be rendered this frame
+struct ShadowRequest {
+    // Light and view of the light, which identify the view from one frame to the next
+    int light;
+    int view;
+    // Rendered whatever the budget, the map would be wrong otherwise
+    bool forced;
+    // Higher first, such as the screen share of the light
+    float priority;
+    // Estimated cost
+    size_t triangles;
+};
+
+// Spreads the shadow map updates over frames. Forced requests, those that waited SHADOW_MAX_INTERVAL frames and the
+// best of the others are always served. The rest are served by decreasing priority times frames waited until the
+// frame's triangle budget runs out. Without a triangle budget, the time budget is turned into one from the
+// measured GPU time per triangle of the previous updates.
+class ShadowScheduler {
+    size_t triangleBudget = 0;
+    float timeBudget = SHADOW_TIME_BUDGET_MS;
+    int maxInterval = SHADOW_MAX_INTERVAL;
+
+    unsigned long frame = 0;
+    std::map<std::pair<int, int>, unsigned long> lastUpdates;
+
+    GLuint queries[SHADOW_TIMER_QUERIES] = {};
+    size_t queryTriangles[SHADOW_TIMER_QUERIES] = {};
+    bool queryPending[SHADOW_TIMER_QUERIES] = {};
+    int query = 0;
+    bool timing = false;
+    // Measured cost, 0 until the first query result
+    double nanosecondsPerTriangle = 0.0;
+
+    void readQueries();
+
+public:
+    void setup();
+
+    // Indices of the requests to serve this frame, in increasing order
+    std::vector<int> schedule(const std::vector<ShadowRequest> &requests);
+
+    // Wrap the caster draws of a frame, about this many triangles, and nothing else such as the EVSM filter
+    void beginTiming(size_t triangles);
+
+    void endTiming();
+
+    // 0 for no triangle budget
+    void setTriangleBudget(size_t triangles);
+
+    // 0 for no time budget
+    void setTimeBudget(float milliseconds);
+
+    void setMaxInterval(int frames);
+
+    [[nodiscard]] double getNanosecondsPerTriangle() const;
+
+    void cleanup();
+};
+
+#endif //SHADOWSCHEDULER_H
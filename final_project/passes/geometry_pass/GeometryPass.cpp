@@ -6,104 +6,165 @@
 
 #include <iostream>
 #include <render/shader.h>
+#include <render/VertexFetch.h>
+
+#include "utils/renderQuad.h"
 
 GeometryPass::GeometryPass(const int width, const int height) : RenderPass(
 	width, height,
 	LoadShadersFromFile("../final_project/shaders/geometry.vert", "../final_project/shaders/geometry.frag")) {
+	invertedNormalsUniform = ProgramUniforms::get(getShaderID()).uniform<int>("invertedNormals");
+	visibilityProgram = LoadShadersFromFile("../final_project/shaders/geometry.vert",
+	                                        "../final_project/shaders/visibility.frag");
+	resolveProgram = LoadShadersFromFile("../final_project/shaders/ssao.vert",
+	                                     "../final_project/shaders/visibility_resolve.frag");
 }
 
 void GeometryPass::setup() {
+	glUseProgram(getShaderID());
+	ProgramUniforms &uniforms = ProgramUniforms::get(getShaderID());
+	uniforms.uniform<int>("drawData").set(DRAW_DATA_TEXTURE_UNIT);
+	uniforms.uniform<int>("materials").set(MATERIAL_TABLE_TEXTURE_UNIT);
+	// Same unit as the skybox, so the sampler2D never shares unit 0 with textureArray
+	uniforms.uniform<int>("textureSampler").set(3);
+
 	glBindFramebuffer(GL_FRAMEBUFFER, getFBO());
 
-	// Position color buffer
-	glGenTextures(1, &gPosition);
-	glBindTexture(GL_TEXTURE_2D, gPosition);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, getWidth(), getHeight(), 0, GL_RGBA, GL_FLOAT, nullptr);
+	// Depth and stencil, sampled by the passes that reconstruct positions from the depth
+	glGenTextures(1, &gDepth);
+	glBindTexture(GL_TEXTURE_2D, gDepth);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, getWidth(), getHeight(), 0, GL_DEPTH_STENCIL,
+	             GL_UNSIGNED_INT_24_8, nullptr);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, gDepth, 0);
 
-	// Normal color buffer
+	// Octahedral view space normal buffer
 	glGenTextures(1, &gNormal);
 	glBindTexture(GL_TEXTURE_2D, gNormal);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, getWidth(), getHeight(), 0, GL_RGBA, GL_FLOAT, nullptr);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16, getWidth(), getHeight(), 0, GL_RG, GL_UNSIGNED_SHORT, nullptr);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gNormal, 0);
 
-	// Color and specular color buffer
+	// Color and material ID buffer
 	glGenTextures(1, &gAlbedo);
 	glBindTexture(GL_TEXTURE_2D, gAlbedo);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, getWidth(), getHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedo, 0);
-
-	// World position color buffer
-	glGenTextures(1, &gPositionWorld);
-	glBindTexture(GL_TEXTURE_2D, gPositionWorld);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, getWidth(), getHeight(), 0, GL_RGBA, GL_FLOAT, nullptr);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, getWidth(), getHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, gPositionWorld, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gAlbedo, 0);
 
-	glGenTextures(1, &gIgnoreLightingPass);
-	glBindTexture(GL_TEXTURE_2D, gIgnoreLightingPass);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, getWidth(), getHeight(), 0, GL_RED, GL_FLOAT, nullptr);
+	// Draw and triangle IDs, only drawn to in the visibility mode
+	glGenTextures(1, &gVisibility);
+	glBindTexture(GL_TEXTURE_2D, gVisibility);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, getWidth(), getHeight(), 0, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT4, GL_TEXTURE_2D, gIgnoreLightingPass, 0);
-
-	const GLuint attachments[5] = {
-		GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4
-	};
-	glDrawBuffers(5, attachments);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gVisibility, 0);
 
-	// Create and attach depth buffer
-	glGenRenderbuffers(1, &rboDepth);
-	glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, getWidth(), getHeight());
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
+	const GLuint attachments[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+	glDrawBuffers(2, attachments);
 
 	//Check if framebuffer is complete
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		std::cout << "Framebuffer not complete!" << std::endl;
+
+	glGenFramebuffers(1, &resolveFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gNormal, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gAlbedo, 0);
+	glDrawBuffers(2, attachments);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Visibility resolve framebuffer not complete!" << std::endl;
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glUseProgram(visibilityProgram);
+	ProgramUniforms &visibilityUniforms = ProgramUniforms::get(visibilityProgram);
+	visibilityUniforms.uniform<int>("drawData").set(DRAW_DATA_TEXTURE_UNIT);
+	visibilityUniforms.uniform<int>("materials").set(MATERIAL_TABLE_TEXTURE_UNIT);
+
+	glUseProgram(resolveProgram);
+	ProgramUniforms &resolveUniforms = ProgramUniforms::get(resolveProgram);
+	resolveUniforms.uniform<int>("drawData").set(DRAW_DATA_TEXTURE_UNIT);
+	resolveUniforms.uniform<int>("materials").set(MATERIAL_TABLE_TEXTURE_UNIT);
+	resolveUniforms.uniform<int>("visibility").set(VISIBILITY_TEXTURE_UNIT);
+	resolveUniforms.uniform<int>("fetchVertices").set(VERTEX_FETCH_VERTICES_TEXTURE_UNIT);
+	resolveUniforms.uniform<int>("fetchIndices").set(VERTEX_FETCH_INDICES_TEXTURE_UNIT);
 }
 
 void GeometryPass::render(const std::vector<GraphicsObject *> &objects, const Camera &camera) {
+	const GLuint attachments[3] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2};
+	const GLuint visibilityAttachments[3] = {GL_NONE, GL_NONE, GL_COLOR_ATTACHMENT2};
+	const bool visibility = mode == GeometryMode::VISIBILITY;
+
 	glBindFramebuffer(GL_FRAMEBUFFER, getFBO());
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glm::mat4 projection = camera.getProjectionMatrix();
-	glm::mat4 view = camera.getViewMatrix();
-	glUseProgram(getShaderID());
-	glUniformMatrix4fv(glGetUniformLocation(getShaderID(), "projection"), 1, GL_FALSE, &projection[0][0]);
-	glUniformMatrix4fv(glGetUniformLocation(getShaderID(), "view"), 1, GL_FALSE, &view[0][0]);
+	glDrawBuffers(2, attachments);
+	glStencilMask(0xFF);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	if (visibility) {
+		// glClear leaves integer buffers undefined
+		const GLuint none[4] = {VISIBILITY_NONE, VISIBILITY_NONE, 0, 0};
+		glDrawBuffers(3, attachments);
+		glClearBufferuiv(GL_COLOR, 2, none);
+	}
 
+	// Each object stamps whether it is lit into the stencil of the pixels it covers
+	glEnable(GL_STENCIL_TEST);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 	for (const auto &object: objects) {
-		glUniform1i(glGetUniformLocation(getShaderID(), "invertedNormals"), 0);
-		object->render(getShaderID());
+		glStencilFunc(GL_ALWAYS, object->isUnlit() ? GBUFFER_STENCIL_UNLIT : 0, 0xFF);
+		if (visibility && object->hasVisibilityResolve()) {
+			glDrawBuffers(3, visibilityAttachments);
+			object->render(visibilityProgram, 1);
+			continue;
+		}
+		// Also clears the visibility of the pixels it covers in the visibility mode
+		if (visibility)
+			glDrawBuffers(3, attachments);
+		glUseProgram(getShaderID());
+		invertedNormalsUniform.set(0);
+		object->render(getShaderID(), 1);
 	}
+	glDisable(GL_STENCIL_TEST);
+
+	if (visibility)
+		resolveVisibility(objects);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void GeometryPass::cleanup() {
-	RenderPass::cleanup();
+void GeometryPass::resolveVisibility(const std::vector<GraphicsObject *> &objects) const {
+	glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+	glDisable(GL_DEPTH_TEST);
+	glActiveTexture(GL_TEXTURE0 + VISIBILITY_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, gVisibility);
 
-	if (gPosition != 0) {
-		glDeleteTextures(1, &gPosition);
-		gPosition = 0;
+	// Every object covers the screen and keeps the pixels of its own draws
+	for (const auto &object: objects) {
+		if (!object->hasVisibilityResolve())
+			continue;
+		object->bindVisibilityResolve(resolveProgram);
+		renderQuad();
 	}
 
-	if (gPositionWorld != 0) {
-		glDeleteTextures(1, &gPositionWorld);
-		gPositionWorld = 0;
+	glActiveTexture(GL_TEXTURE0 + VISIBILITY_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glEnable(GL_DEPTH_TEST);
+}
+
+void GeometryPass::cleanup() {
+	RenderPass::cleanup();
+
+	if (gDepth != 0) {
+		glDeleteTextures(1, &gDepth);
+		gDepth = 0;
 	}
 
 	if (gNormal != 0) {
@@ -116,23 +177,23 @@ void GeometryPass::cleanup() {
 		gAlbedo = 0;
 	}
 
-	if (gIgnoreLightingPass != 0) {
-		glDeleteTextures(1, &gIgnoreLightingPass);
-		gIgnoreLightingPass = 0;
+	if (gVisibility != 0) {
+		glDeleteTextures(1, &gVisibility);
+		gVisibility = 0;
 	}
 
-	if (rboDepth != 0) {
-		glDeleteRenderbuffers(1, &rboDepth);
-		rboDepth = 0;
+	if (resolveFBO != 0) {
+		glDeleteFramebuffers(1, &resolveFBO);
+		resolveFBO = 0;
 	}
-}
 
-GLuint GeometryPass::getGPosition() const {
-	return gPosition;
+	glDeleteProgram(visibilityProgram);
+	glDeleteProgram(resolveProgram);
+	visibilityProgram = resolveProgram = 0;
 }
 
-GLuint GeometryPass::getGPositionWorld() const {
-	return gPositionWorld;
+GLuint GeometryPass::getGDepth() const {
+	return gDepth;
 }
 
 GLuint GeometryPass::getGNormal() const {
@@ -143,11 +204,10 @@ GLuint GeometryPass::getGAlbedo() const {
 	return gAlbedo;
 }
 
-GLuint GeometryPass::getGIgnoreLightingPass() const {
-	return gIgnoreLightingPass;
+void GeometryPass::setMode(const GeometryMode mode) {
+	this->mode = mode;
 }
 
-GLuint GeometryPass::getRboDepth() const {
-	return rboDepth;
+GeometryMode GeometryPass::getMode() const {
+	return mode;
 }
-
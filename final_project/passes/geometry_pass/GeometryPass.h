@@ -5,15 +5,49 @@
 #ifndef GEOMETRYPASS_H
 #define GEOMETRYPASS_H
 #include "passes/render_pass/RenderPass.h"
+#include "render/DrawDataRing.h"
+#include "render/ProgramUniforms.h"
 
+// Stencil value of the pixels the lighting leaves as they are, such as the sky
+#define GBUFFER_STENCIL_UNLIT 1
 
+// Texture unit of the visibility buffer in its resolve
+#define VISIBILITY_TEXTURE_UNIT 19
+// Draw ID of the pixels without a triangle to resolve, mirrored in shaders/common/visibility.glsl
+#define VISIBILITY_NONE 0xFFFFFFFFu
+
+// How the G-buffer is filled
+enum class GeometryMode {
+    // Every fragment rasterized writes its material attributes
+    DEFERRED,
+    // Fragments only write their draw and triangle IDs into a visibility buffer. A full screen resolve per object
+    // then fetches the visible triangle of each pixel and evaluates its material once. Objects without a resolve
+    // path, see GraphicsObject::hasVisibilityResolve, are rasterized as in DEFERRED.
+    VISIBILITY
+};
+
+// Fills the G-buffer, 12 bytes per pixel read back by shaders/common/gbuffer.glsl:
+// - gDepth, depth and stencil, the view and world positions are reconstructed from the depth with the inverse
+//   matrices of the camera, the stencil is GBUFFER_STENCIL_UNLIT on unlit pixels
+// - gNormal, RG16 view space normals in octahedral encoding
+// - gAlbedo, RGBA8 base color with the material ID in alpha, 0 on unlit pixels. Shaders cannot read the stencil
+//   under OpenGL 3.3, they test the ID instead while fixed function stencil tests skip the unlit pixels.
+// In the VISIBILITY mode, gVisibility holds the RG32UI draw and triangle IDs of shaders/common/visibility.glsl.
 class GeometryPass : public RenderPass {
-    GLuint gPosition = 0;
-    GLuint gPositionWorld = 0;
+    GLuint gDepth = 0;
     GLuint gNormal = 0;
     GLuint gAlbedo = 0;
-    GLuint gIgnoreLightingPass = 0;
-    GLuint rboDepth = 0;
+    GLuint gVisibility = 0;
+
+    GeometryMode mode = GeometryMode::DEFERRED;
+    GLuint visibilityProgram = 0;
+    GLuint resolveProgram = 0;
+    // gNormal and gAlbedo alone, the resolve reads the visibility buffer it must not be attached to
+    GLuint resolveFBO = 0;
+
+    Uniform<int> invertedNormalsUniform;
+
+    void resolveVisibility(const std::vector<GraphicsObject *> &objects) const;
 
 public:
     GeometryPass(int width, int height);
@@ -24,17 +58,15 @@ public:
 
     void cleanup() override;
 
-    [[nodiscard]] GLuint getGPosition() const;
-
-    [[nodiscard]] GLuint getGPositionWorld() const;
+    [[nodiscard]] GLuint getGDepth() const;
 
     [[nodiscard]] GLuint getGNormal() const;
 
     [[nodiscard]] GLuint getGAlbedo() const;
 
-    [[nodiscard]] GLuint getGIgnoreLightingPass() const;
+    void setMode(GeometryMode mode);
 
-    [[nodiscard]] GLuint getRboDepth() const;
+    [[nodiscard]] GeometryMode getMode() const;
 };
 
 
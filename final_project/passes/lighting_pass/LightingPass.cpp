@@ -5,86 +5,101 @@
 #include "LightingPass.h"
 
 #include <render/shader.h>
+#include <render/ProgramUniforms.h>
 
 #include "utils/renderQuad.h"
 
-LightingPass::LightingPass(const int width, const int height, std::vector<Light *> &lights, GeometryPass &geometryPass,
-                           SSAOBlurPass &ssaoBlurPass, DepthPass &depthPass) : RenderPass(width, height,
-                                                                                   LoadShadersFromFile(
-                                                                                       "../final_project/shaders/ssao.vert",
-                                                                                       "../final_project/shaders/lighting.frag")),
-                                                                               geometryPass(geometryPass),
-                                                                               ssaoBlurPass(ssaoBlurPass),
-                                                                               depthPass(depthPass), lights(lights) {
+LightingPass::LightingPass(const int width, const int height, const Camera &camera, std::vector<Light *> &lights,
+                           GeometryPass &geometryPass, SSAOBlurPass &ssaoBlurPass, DepthPass &depthPass) :
+    RenderPass(width, height,
+               LoadShadersFromFile("../final_project/shaders/ssao.vert", "../final_project/shaders/lighting.frag")),
+    lightClusters(width, height), stochasticLighting(width, height), shadowMask(width, height), camera(camera),
+    geometryPass(geometryPass), ssaoBlurPass(ssaoBlurPass), depthPass(depthPass), lights(lights) {
 }
 
 void LightingPass::setup() {
     glUseProgram(getShaderID());
-    glUniform1i(glGetUniformLocation(getShaderID(), "gPosition"), 0);
-    glUniform1i(glGetUniformLocation(getShaderID(), "gPositionWorld"), 1);
-    glUniform1i(glGetUniformLocation(getShaderID(), "gNormal"), 2);
-    glUniform1i(glGetUniformLocation(getShaderID(), "gAlbedo"), 3);
-    glUniform1i(glGetUniformLocation(getShaderID(), "ssao"), 4);
-    glUniform1i(glGetUniformLocation(getShaderID(), "gIgnoreLightingPass"), 5);
-    glUniform1i(glGetUniformLocation(getShaderID(), "depthArray"), 6);
-}
-
-void LightingPass::loadLightsUBOs() {
-    // Define the size of the UBO: two glm::vec3 (position + intensity) per light
-    const size_t uboSize = sizeof(lightStruct) * lights.size();
-
-    // Generate and bind the UBO
-    glGenBuffers(1, &lightsUBO);
-    glBindBuffer(GL_UNIFORM_BUFFER, lightsUBO);
-    glBufferData(GL_UNIFORM_BUFFER, static_cast<long long>(uboSize), nullptr, GL_DYNAMIC_DRAW);
-
-    // Load light data into the UBO
-    lightStruct uboData[lights.size()];
-    for (int i = 0; i < lights.size(); i++) {
-        uboData[i] = lights[i]->toStruct();
-    }
-
-    // Copy the data to the UBO
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<long long>(uboSize), &uboData);
-
-    // Unbind the UBO
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
-
-    const GLuint blockIndex = glGetUniformBlockIndex(getShaderID(), "Lights");
-
-    // Bind the UBO to the block index
-    glUniformBlockBinding(getShaderID(), blockIndex, 0);
-
-    // Bind the UBO to the binding point 0
-    glBindBufferBase(GL_UNIFORM_BUFFER, 0, lightsUBO);
+    ProgramUniforms &uniforms = ProgramUniforms::get(getShaderID());
+    uniforms.uniform<int>("gDepth").set(0);
+    uniforms.uniform<int>("gNormal").set(2);
+    uniforms.uniform<int>("gAlbedo").set(3);
+    uniforms.uniform<int>("ssao").set(4);
+    uniforms.uniform<int>("shadowAtlas").set(6);
+    uniforms.uniform<int>("shadowMoments").set(SHADOW_MOMENTS_TEXTURE_UNIT);
+    uniforms.uniform<int>("staticDistanceField").set(DISTANCE_FIELD_TEXTURE_UNIT);
+    uniforms.uniform<int>("shadowMask0").set(SHADOW_MASK_TEXTURE_UNIT);
+    uniforms.uniform<int>("shadowMask1").set(SHADOW_MASK_TEXTURE_UNIT + 1);
+    uniforms.uniform<int>("lightData").set(LIGHTS_TEXTURE_UNIT);
+
+    lightBuffer.setup(256);
+
+    lightClusters.setup(camera);
+    uniforms.uniform<int>("clusterOffsets").set(CLUSTER_OFFSETS_TEXTURE_UNIT);
+    uniforms.uniform<int>("clusterLights").set(CLUSTER_LIGHTS_TEXTURE_UNIT);
+    uniforms.uniform<glm::ivec4>("clusterGrid").set(lightClusters.getGrid());
+    uniforms.uniform<glm::vec2>("clusterSlicing").set(lightClusters.getSlicing());
+
+    stochasticLighting.setup();
+    shadowMask.setup();
 }
 
 void LightingPass::render(const std::vector<GraphicsObject *> &objects, const Camera &camera) {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glUseProgram(getShaderID());
 
-    loadLightsUBOs();
+    // Only the lights that moved since the last frame are uploaded again, the mask slots are part of them
+    shadowMask.assignSlots(lights);
+    lightBuffer.update(lights);
+    lightBuffer.bind(LIGHTS_TEXTURE_UNIT);
 
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, geometryPass.getGPosition());
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, geometryPass.getGPositionWorld());
+    glBindTexture(GL_TEXTURE_2D, geometryPass.getGDepth());
     glActiveTexture(GL_TEXTURE2);
     glBindTexture(GL_TEXTURE_2D, geometryPass.getGNormal());
     glActiveTexture(GL_TEXTURE3);
     glBindTexture(GL_TEXTURE_2D, geometryPass.getGAlbedo());
     glActiveTexture(GL_TEXTURE4); // add extra SSAO texture to lighting pass
     glBindTexture(GL_TEXTURE_2D, ssaoBlurPass.getColorBufferBlur());
-    glActiveTexture(GL_TEXTURE5); // add extra SSAO texture to lighting pass
-    glBindTexture(GL_TEXTURE_2D, geometryPass.getGIgnoreLightingPass());
     glActiveTexture(GL_TEXTURE6);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, depthPass.getDepthTexturesArray());
+    glBindTexture(GL_TEXTURE_2D, depthPass.getShadowAtlas());
+    glActiveTexture(GL_TEXTURE0 + SHADOW_MOMENTS_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, depthPass.getShadowMoments());
+    glActiveTexture(GL_TEXTURE0 + DISTANCE_FIELD_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_3D, depthPass.getDistanceField().getTexture());
+
+    // Shadows of the lights with a mask channel, before the lighting reads them
+    shadowMask.render();
+    shadowMask.bind();
+
+    if (strategy == LightingStrategy::STOCHASTIC) {
+        stochasticLighting.render(camera, lightBuffer.getLightCount());
+        return;
+    }
+
+    lightClusters.update(camera, lights);
+    lightClusters.bind();
+
+    glUseProgram(getShaderID());
     renderQuad();
 }
 
+void LightingPass::setStrategy(const LightingStrategy strategy) {
+    // The reservoirs of the last stochastic frame are stale once another strategy ran
+    if (strategy != this->strategy)
+        stochasticLighting.reset();
+    this->strategy = strategy;
+}
+
+LightingStrategy LightingPass::getStrategy() const {
+    return strategy;
+}
+
+ShadowMask &LightingPass::getShadowMask() {
+    return shadowMask;
+}
+
 void LightingPass::cleanup() {
-    if (lightsUBO != 0) {
-        glDeleteBuffers(1, &lightsUBO);
-        lightsUBO = 0;
-    }
+    lightBuffer.cleanup();
+    lightClusters.cleanup();
+    stochasticLighting.cleanup();
+    shadowMask.cleanup();
 }
@@ -7,26 +7,43 @@
 #include "passes/depth_pass/DepthPass.h"
 #include "passes/geometry_pass/GeometryPass.h"
 #include "passes/ssao_blur_pass/SSAOBlurPass.h"
-
+#include "passes/lighting_pass/ShadowMask.h"
+#include "passes/lighting_pass/StochasticLighting.h"
+#include "render/LightBuffer.h"
+#include "render/LightClusters.h"
+#include "render/ProgramUniforms.h"
+
+enum class LightingStrategy {
+    CLUSTERED,      // Every light of the cluster, with its shadow map
+    STOCHASTIC      // A few resampled lights per pixel, see StochasticLighting
+};
 
 class LightingPass : public RenderPass {
-    GLuint lightsUBO = 0;
+    LightBuffer lightBuffer;
+    LightClusters lightClusters;
+    StochasticLighting stochasticLighting;
+    ShadowMask shadowMask;
+    LightingStrategy strategy = LightingStrategy::CLUSTERED;
+    const Camera &camera;
 
     GeometryPass &geometryPass;
     SSAOBlurPass &ssaoBlurPass;
     DepthPass &depthPass;
     std::vector<Light *> &lights;
 
-    void loadLightsUBOs();
-
 public:
-    LightingPass(int width, int height, std::vector<Light *> &lights, GeometryPass &geometryPass,
-                 SSAOBlurPass &ssaoBlurPass, DepthPass &depthPass);
+    LightingPass(int width, int height, const Camera &camera, std::vector<Light *> &lights,
+                 GeometryPass &geometryPass, SSAOBlurPass &ssaoBlurPass, DepthPass &depthPass);
 
     void setup() override;
 
     void render(const std::vector<GraphicsObject *> &objects, const Camera &camera) override;
 
+    void setStrategy(LightingStrategy strategy);
+    [[nodiscard]] LightingStrategy getStrategy() const;
+
+    [[nodiscard]] ShadowMask &getShadowMask();
+
     void cleanup() override;
 };
 
@@ -0,0 +1,132 @@
+#include "ShadowMask.h"
+
+#include <algorithm>
+#include <iostream>
+#include <render/shader.h>
+#include <render/ProgramUniforms.h>
+#include <render/FrameUniforms.h>
+#include <render/LightBuffer.h>
+#include <passes/depth_pass/ShadowDistanceField.h>
+#include <passes/depth_pass/ShadowFilter.h>
+
+#include "utils/renderQuad.h"
+
+ShadowMask::ShadowMask(const int width, const int height) : width(width), height(height) {
+}
+
+void ShadowMask::setup() {
+    program = LoadShadersFromFile("../final_project/shaders/ssao.vert", "../final_project/shaders/shadow_mask.frag");
+    glUseProgram(program);
+    ProgramUniforms &uniforms = ProgramUniforms::get(program);
+    uniforms.uniform<int>("gDepth").set(0);
+    uniforms.uniform<int>("gNormal").set(2);
+    uniforms.uniform<int>("gAlbedo").set(3);
+    uniforms.uniform<int>("shadowAtlas").set(6);
+    uniforms.uniform<int>("lightData").set(LIGHTS_TEXTURE_UNIT);
+    uniforms.uniform<int>("shadowMoments").set(SHADOW_MOMENTS_TEXTURE_UNIT);
+    uniforms.uniform<int>("staticDistanceField").set(DISTANCE_FIELD_TEXTURE_UNIT);
+
+    createTargets();
+}
+
+void ShadowMask::createTargets() {
+    const int maskWidth = (width + scale - 1) / scale;
+    const int maskHeight = (height + scale - 1) / scale;
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glGenTextures(2, textures);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, maskWidth, maskHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, textures[i], 0);
+    }
+    constexpr GLenum attachments[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, attachments);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Shadow mask Framebuffer not complete!" << std::endl;
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowMask::deleteTargets() {
+    if (fbo != 0) {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(2, textures);
+        fbo = 0;
+        textures[0] = textures[1] = 0;
+    }
+}
+
+void ShadowMask::assignSlots(const std::vector<Light *> &lights) {
+    // The same lights the shading would sample a shadow map for, only the first directional light has cascades
+    const int cascadeLight = FrameUniforms::findCascadeLight(lights);
+    int slot = 0;
+    slotLights[0] = slotLights[1] = glm::ivec4(-1);
+    for (int i = 0; i < lights.size(); i++) {
+        Light &light = *lights[i];
+        const bool shadowed = light.getShadowFade() > 0.0f && light.getShadowRect().z > 0.0f &&
+                              (light.getType() != DIRECTIONAL_LIGHT || i == cascadeLight);
+        if (enabled && shadowed && slot < SHADOW_MASK_LIGHTS) {
+            slotLights[slot / 4][slot % 4] = i;
+            light.setShadowMaskSlot(slot++);
+        } else {
+            light.setShadowMaskSlot(-1);
+        }
+    }
+}
+
+void ShadowMask::render() {
+    if (slotLights[0].x < 0)
+        return;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, (width + scale - 1) / scale, (height + scale - 1) / scale);
+    glUseProgram(program);
+    ProgramUniforms &uniforms = ProgramUniforms::get(program);
+    uniforms.uniform<glm::ivec4>("maskLights").set(slotLights, 2);
+    uniforms.uniform<int>("scale").set(scale);
+    renderQuad();
+    glViewport(0, 0, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowMask::bind() const {
+    for (int i = 0; i < 2; i++) {
+        glActiveTexture(GL_TEXTURE0 + SHADOW_MASK_TEXTURE_UNIT + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void ShadowMask::setEnabled(const bool enabled) {
+    this->enabled = enabled;
+}
+
+bool ShadowMask::isEnabled() const {
+    return enabled;
+}
+
+void ShadowMask::setScale(const int scale) {
+    const int clamped = std::max(scale, 1);
+    if (clamped == this->scale)
+        return;
+    this->scale = clamped;
+    if (fbo != 0) {
+        deleteTargets();
+        createTargets();
+    }
+}
+
+int ShadowMask::getScale() const {
+    return scale;
+}
+
+void ShadowMask::cleanup() {
+    deleteTargets();
+    glDeleteProgram(program);
+}
@@ -0,0 +1,64 @@
+#ifndef SHADOWMASK_H
+#define SHADOWMASK_H
+#include <vector>
+#include <glm/glm.hpp>
+#include "glad/gl.h"
+#include "view_points/lights/light/Light.h"
+
+// Texture units of the two mask targets, past the 16 units a single stage may sample from at once
+#define SHADOW_MASK_TEXTURE_UNIT 16
+// Lights the mask holds, 4 per RGBA8 target, mirrored in shaders/common/shadow_mask.glsl
+#define SHADOW_MASK_LIGHTS 8
+// Screen pixels per mask texel along each axis
+#define SHADOW_MASK_DEFAULT_SCALE 2
+
+// Screen-space visibility of the shadowed lights, so the lighting reads one mask texel per pixel instead of doing
+// the projection and shadow map lookups of every light. The first SHADOW_MASK_LIGHTS lights with a shadow get a
+// channel, through Light::setShadowMaskSlot, any other shadowed light is still sampled by the lighting. The mask is
+// rendered at 1 / scale of the screen resolution and upsampled with a depth-aware bilinear filter where it is read
+// (shaders/common/shadow_mask.glsl).
+//
+// Expects the G-buffer, shadow maps and lights on the texture units LightingPass binds them to.
+class ShadowMask {
+    int width, height;
+    int scale = SHADOW_MASK_DEFAULT_SCALE;
+    bool enabled = true;
+
+    GLuint program = 0;
+    GLuint fbo = 0;
+    GLuint textures[2] = {};
+    // Light of each slot, -1 for an empty one
+    glm::ivec4 slotLights[2] = {glm::ivec4(-1), glm::ivec4(-1)};
+
+    void createTargets();
+
+    void deleteTargets();
+
+public:
+    ShadowMask(int width, int height);
+
+    void setup();
+
+    // Gives the shadowed lights their channel, before the lights are uploaded
+    void assignSlots(const std::vector<Light *> &lights);
+
+    // Renders the visibility of the lights with a channel
+    void render();
+
+    // Binds the targets for the lighting to read
+    void bind() const;
+
+    // Lights keep sampling their own shadow maps when disabled
+    void setEnabled(bool enabled);
+
+    [[nodiscard]] bool isEnabled() const;
+
+    // Recreates the targets at the new resolution
+    void setScale(int scale);
+
+    [[nodiscard]] int getScale() const;
+
+    void cleanup();
+};
+
+#endif //SHADOWMASK_H
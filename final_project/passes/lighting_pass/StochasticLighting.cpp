@@ -0,0 +1,148 @@
+#include "StochasticLighting.h"
+
+#include <iostream>
+#include <render/shader.h>
+#include <render/ProgramUniforms.h>
+#include <render/LightBuffer.h>
+#include <passes/depth_pass/ShadowDistanceField.h>
+#include <passes/depth_pass/ShadowFilter.h>
+#include <passes/lighting_pass/ShadowMask.h>
+
+#include "utils/renderQuad.h"
+
+static const UniformName LIGHT_COUNT("lightCount");
+static const UniformName FRAME_INDEX("frameIndex");
+
+static GLuint createTexture(const int width, const int height, const GLint internalFormat) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+StochasticLighting::StochasticLighting(const int width, const int height) : width(width), height(height) {
+    reservoirProgram = LoadShadersFromFile("../final_project/shaders/ssao.vert",
+                                           "../final_project/shaders/restir_reservoir.frag");
+    shadeProgram = LoadShadersFromFile("../final_project/shaders/ssao.vert",
+                                       "../final_project/shaders/restir_shade.frag");
+    denoiseProgram = LoadShadersFromFile("../final_project/shaders/ssao.vert",
+                                         "../final_project/shaders/restir_denoise.frag");
+}
+
+void StochasticLighting::setGBufferUnits(const GLuint program) {
+    glUseProgram(program);
+    ProgramUniforms &uniforms = ProgramUniforms::get(program);
+    uniforms.uniform<int>("gDepth").set(0);
+    uniforms.uniform<int>("gNormal").set(2);
+    uniforms.uniform<int>("gAlbedo").set(3);
+    uniforms.uniform<int>("ssao").set(4);
+    uniforms.uniform<int>("shadowAtlas").set(6);
+    uniforms.uniform<int>("shadowMoments").set(SHADOW_MOMENTS_TEXTURE_UNIT);
+    uniforms.uniform<int>("staticDistanceField").set(DISTANCE_FIELD_TEXTURE_UNIT);
+    uniforms.uniform<int>("shadowMask0").set(SHADOW_MASK_TEXTURE_UNIT);
+    uniforms.uniform<int>("shadowMask1").set(SHADOW_MASK_TEXTURE_UNIT + 1);
+    uniforms.uniform<int>("lightData").set(LIGHTS_TEXTURE_UNIT);
+}
+
+void StochasticLighting::setup() {
+    for (int i = 0; i < 2; i++) {
+        glGenFramebuffers(1, &reservoirFBOs[i]);
+        glBindFramebuffer(GL_FRAMEBUFFER, reservoirFBOs[i]);
+
+        reservoirTextures[i] = createTexture(width, height, GL_RGBA32F);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, reservoirTextures[i], 0);
+        positionTextures[i] = createTexture(width, height, GL_RGBA32F);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, positionTextures[i], 0);
+
+        constexpr GLenum attachments[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, attachments);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Reservoir Framebuffer not complete!" << std::endl;
+    }
+
+    glGenFramebuffers(1, &radianceFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, radianceFBO);
+    radianceTexture = createTexture(width, height, GL_RGBA16F);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, radianceTexture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Radiance Framebuffer not complete!" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    setGBufferUnits(reservoirProgram);
+    ProgramUniforms::get(reservoirProgram).uniform<int>("previousReservoirs").set(RESERVOIRS_TEXTURE_UNIT);
+    ProgramUniforms::get(reservoirProgram).uniform<int>("previousPositions").set(PREVIOUS_POSITIONS_TEXTURE_UNIT);
+
+    setGBufferUnits(shadeProgram);
+    ProgramUniforms::get(shadeProgram).uniform<int>("reservoirs").set(RESERVOIRS_TEXTURE_UNIT);
+
+    setGBufferUnits(denoiseProgram);
+    ProgramUniforms::get(denoiseProgram).uniform<int>("radiance").set(RADIANCE_TEXTURE_UNIT);
+}
+
+void StochasticLighting::render(const Camera &camera, const int lightCount) {
+    const int current = frameIndex % 2;
+    const int previous = 1 - current;
+
+    // Candidates and temporal reuse
+    glBindFramebuffer(GL_FRAMEBUFFER, reservoirFBOs[current]);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glUseProgram(reservoirProgram);
+    ProgramUniforms &reservoirUniforms = ProgramUniforms::get(reservoirProgram);
+    reservoirUniforms.uniform<int>(LIGHT_COUNT).set(lightCount);
+    reservoirUniforms.uniform<int>(FRAME_INDEX).set(frameIndex);
+    reservoirUniforms.uniform<int>("temporalReuse").set(hasHistory ? 1 : 0);
+    reservoirUniforms.uniform<glm::mat4>("previousViewProjection").set(previousViewProjection);
+    glActiveTexture(GL_TEXTURE0 + RESERVOIRS_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, reservoirTextures[previous]);
+    glActiveTexture(GL_TEXTURE0 + PREVIOUS_POSITIONS_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, positionTextures[previous]);
+    renderQuad();
+
+    // Spatial reuse and shading of the selected lights
+    glBindFramebuffer(GL_FRAMEBUFFER, radianceFBO);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glUseProgram(shadeProgram);
+    ProgramUniforms &shadeUniforms = ProgramUniforms::get(shadeProgram);
+    shadeUniforms.uniform<int>(LIGHT_COUNT).set(lightCount);
+    shadeUniforms.uniform<int>(FRAME_INDEX).set(frameIndex);
+    glActiveTexture(GL_TEXTURE0 + RESERVOIRS_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, reservoirTextures[current]);
+    renderQuad();
+
+    // Denoise, ambient and gamma into the default framebuffer
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glUseProgram(denoiseProgram);
+    glActiveTexture(GL_TEXTURE0 + RADIANCE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, radianceTexture);
+    renderQuad();
+    glActiveTexture(GL_TEXTURE0);
+
+    previousViewProjection = camera.getVPMatrix();
+    hasHistory = true;
+    frameIndex++;
+}
+
+void StochasticLighting::reset() {
+    hasHistory = false;
+}
+
+void StochasticLighting::cleanup() {
+    for (int i = 0; i < 2; i++) {
+        glDeleteFramebuffers(1, &reservoirFBOs[i]);
+        glDeleteTextures(1, &reservoirTextures[i]);
+        glDeleteTextures(1, &positionTextures[i]);
+        reservoirFBOs[i] = reservoirTextures[i] = positionTextures[i] = 0;
+    }
+    glDeleteFramebuffers(1, &radianceFBO);
+    glDeleteTextures(1, &radianceTexture);
+    radianceFBO = radianceTexture = 0;
+
+    glDeleteProgram(reservoirProgram);
+    glDeleteProgram(shadeProgram);
+    glDeleteProgram(denoiseProgram);
+}
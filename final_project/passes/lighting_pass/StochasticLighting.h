@@ -0,0 +1,52 @@
+#ifndef STOCHASTICLIGHTING_H
+#define STOCHASTICLIGHTING_H
+#include <glm/glm.hpp>
+#include "glad/gl.h"
+#include "view_points/camera/camera.h"
+
+// Texture units of the intermediate buffers, after the G-buffer, shadow and light units of LightingPass
+#define RESERVOIRS_TEXTURE_UNIT 12
+#define PREVIOUS_POSITIONS_TEXTURE_UNIT 13
+#define RADIANCE_TEXTURE_UNIT 14
+
+// Lighting strategy whose cost does not depend on the light count. Each pixel resamples a few light candidates in
+// proportion to their unshadowed contribution into a reservoir, merges the reservoir of the same surface last frame
+// and those of a few neighbours, then shades the one light it kept with its shadow map. A bilateral filter guided
+// by the G-buffer removes the remaining noise.
+//
+// Expects the G-buffer, SSAO, shadow maps and lights on the texture units LightingPass binds them to.
+class StochasticLighting {
+    int width, height;
+
+    GLuint reservoirProgram;
+    GLuint shadeProgram;
+    GLuint denoiseProgram;
+
+    // Reservoirs and world positions, written one frame and read back as history the next
+    GLuint reservoirFBOs[2] = {};
+    GLuint reservoirTextures[2] = {};
+    GLuint positionTextures[2] = {};
+    GLuint radianceFBO = 0;
+    GLuint radianceTexture = 0;
+
+    int frameIndex = 0;
+    bool hasHistory = false;
+    glm::mat4 previousViewProjection = glm::mat4(1.0f);
+
+    static void setGBufferUnits(GLuint program);
+
+public:
+    StochasticLighting(int width, int height);
+
+    void setup();
+
+    // Renders the lit image into the default framebuffer
+    void render(const Camera &camera, int lightCount);
+
+    // Drops the history, after a camera cut or a change of strategy
+    void reset();
+
+    void cleanup();
+};
+
+#endif //STOCHASTICLIGHTING_H
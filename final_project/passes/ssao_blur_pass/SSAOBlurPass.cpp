@@ -6,14 +6,17 @@
 
 #include <iostream>
 #include <render/shader.h>
+#include <render/ProgramUniforms.h>
 
 #include "utils/renderQuad.h"
 
-SSAOBlurPass::SSAOBlurPass(int width, int height, SSAOPass &ssaoPass) : RenderPass(width, height,
+SSAOBlurPass::SSAOBlurPass(int width, int height, SSAOPass &ssaoPass, GeometryPass &geometryPass) : RenderPass(
+                                                                            width, height,
                                                                             LoadShadersFromFile(
                                                                                 "../final_project/shaders/ssao.vert",
                                                                                 "../final_project/shaders/ssao_blur.frag")),
-                                                                        ssaoPass(ssaoPass) {
+                                                                        ssaoPass(ssaoPass),
+                                                                        geometryPass(geometryPass) {
 }
 
 
@@ -26,11 +29,13 @@ void SSAOBlurPass::setup() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBufferBlur, 0);
+    // The stencil of the G-buffer, only to test it, the depth is neither tested nor written
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, geometryPass.getGDepth(), 0);
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "SSAO Blur Framebuffer not complete!" << std::endl;
 
     glUseProgram(getShaderID());
-    glUniform1i(glGetUniformLocation(getShaderID(), "ssaoInput"), 0);
+    ProgramUniforms::get(getShaderID()).uniform<int>("ssaoInput").set(0);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
@@ -41,7 +46,16 @@ void SSAOBlurPass::render(const std::vector<GraphicsObject *> &objects, const Ca
     glUseProgram(getShaderID());
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, ssaoPass.getColorBuffer());
+
+    // The lighting never reads the occlusion of unlit pixels
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_STENCIL_TEST);
+    glStencilFunc(GL_NOTEQUAL, GBUFFER_STENCIL_UNLIT, 0xFF);
+    glStencilMask(0x00);
     renderQuad();
+    glStencilMask(0xFF);
+    glDisable(GL_STENCIL_TEST);
+    glEnable(GL_DEPTH_TEST);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
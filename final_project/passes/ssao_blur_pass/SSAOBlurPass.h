@@ -11,9 +11,10 @@
 class SSAOBlurPass : public RenderPass{
     GLuint ssaoColorBufferBlur = 0;
     SSAOPass &ssaoPass;
+    GeometryPass &geometryPass;
 
     public:
-        SSAOBlurPass(int width, int height, SSAOPass &ssaoPass);
+        SSAOBlurPass(int width, int height, SSAOPass &ssaoPass, GeometryPass &geometryPass);
 
         void setup() override;
         void render(const std::vector<GraphicsObject*>& objects, const Camera& camera) override;
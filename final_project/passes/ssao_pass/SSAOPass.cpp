@@ -6,6 +6,7 @@
 
 #include <iostream>
 #include <render/shader.h>
+#include <render/ProgramUniforms.h>
 
 #include "utils/renderQuad.h"
 
@@ -62,9 +63,11 @@ void SSAOPass::setup() {
         std::cout << "SSAO Framebuffer not complete!" << std::endl;
 
     glUseProgram(getShaderID());
-    glUniform1i(glGetUniformLocation(getShaderID(), "gPosition"), 0);
-    glUniform1i(glGetUniformLocation(getShaderID(), "gNormal"), 1);
-    glUniform1i(glGetUniformLocation(getShaderID(), "texNoise"), 2);
+    ProgramUniforms &uniforms = ProgramUniforms::get(getShaderID());
+    uniforms.uniform<int>("gDepth").set(0);
+    uniforms.uniform<int>("gNormal").set(1);
+    uniforms.uniform<int>("texNoise").set(2);
+    uniforms.uniform<int>("gAlbedo").set(3);
 
     loadNoiseTexture();
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -75,19 +78,14 @@ void SSAOPass::render(const std::vector<GraphicsObject *> &objects, const Camera
     glClear(GL_COLOR_BUFFER_BIT);
     glUseProgram(getShaderID());
 
-    // Send kernel + rotation
-    for (unsigned int i = 0; i < 64; ++i)
-        glUniform3fv(glGetUniformLocation(getShaderID(), ("samples[" + std::to_string(i) + "]").c_str()), 1,
-                     &ssaoKernel[i][0]);
-
-    glm::mat4 projection = camera.getProjectionMatrix();
-    glUniformMatrix4fv(glGetUniformLocation(getShaderID(), "projection"), 1, GL_FALSE, &projection[0][0]);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, geometryPass.getGPosition());
+    glBindTexture(GL_TEXTURE_2D, geometryPass.getGDepth());
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, geometryPass.getGNormal());
     glActiveTexture(GL_TEXTURE2);
     glBindTexture(GL_TEXTURE_2D, noiseTexture);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, geometryPass.getGAlbedo());
     renderQuad();
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
@@ -107,4 +105,8 @@ GLuint SSAOPass::getColorBuffer() const {
     return ssaoColorBuffer;
 }
 
+const std::vector<glm::vec3> &SSAOPass::getKernel() const {
+    return ssaoKernel;
+}
+
 
@@ -36,6 +36,9 @@ public:
     void cleanup() override;
 
     [[nodiscard]] GLuint getColorBuffer() const;
+
+    // Sent to the shader through the FrameUniforms block
+    [[nodiscard]] const std::vector<glm::vec3> &getKernel() const;
 };
 
 
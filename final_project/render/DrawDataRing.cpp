@@ -0,0 +1,126 @@
+#include "DrawDataRing.h"
+
+#include <cstring>
+#include <iostream>
+
+// GL_ARB_buffer_storage, not part of the GL 3.3 headers
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+typedef void (GLAD_API_PTR *PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+static bool hasExtension(const char *name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLuint i = 0; i < count; i++) {
+        if (std::strcmp(reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i)), name) == 0)
+            return true;
+    }
+    return false;
+}
+
+DrawDataRing::DrawDataRing(const size_t texelsPerFrame) : regionTexels(texelsPerFrame) {
+}
+
+void DrawDataRing::setup(const GLADloadfunc load) {
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+
+    const auto bufferStorage = hasExtension("GL_ARB_buffer_storage")
+                                   ? reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(load("glBufferStorage"))
+                                   : nullptr;
+    if (bufferStorage) {
+        const auto size = static_cast<GLsizeiptr>(regionTexels * regionCount * sizeof(glm::vec4));
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(GL_TEXTURE_BUFFER, size, nullptr, flags);
+        mapped = static_cast<glm::vec4 *>(glMapBufferRange(GL_TEXTURE_BUFFER, 0, size, flags));
+    }
+
+    if (!mapped) {
+        // Orphaning already gives the driver a fresh buffer every frame, a single region is enough
+        std::cout << "Persistent mapping not available, draw data is uploaded every frame" << std::endl;
+        regionCount = 1;
+        staging.resize(regionTexels);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(regionTexels * sizeof(glm::vec4)), nullptr,
+                     GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void DrawDataRing::beginFrame() {
+    if (GLsync &fence = fences[region]) {
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    used = 0;
+}
+
+int DrawDataRing::allocate(const int texels, glm::vec4 *&data) {
+    if (used + texels > regionTexels) {
+        if (!overflowReported)
+            std::cerr << "Draw data ring is full, increase its size" << std::endl;
+        overflowReported = true;
+
+        // The data is dropped and the draws read whatever is at the start of the region
+        overflow.resize(texels);
+        data = overflow.data();
+        return static_cast<int>(region * regionTexels);
+    }
+
+    const size_t first = region * regionTexels + used;
+    data = mapped ? mapped + first : staging.data() + used;
+    used += texels;
+    return static_cast<int>(first);
+}
+
+void DrawDataRing::flush() {
+    if (!mapped && used > 0) {
+        const auto size = static_cast<GLsizeiptr>(regionTexels * sizeof(glm::vec4));
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, static_cast<GLsizeiptr>(used * sizeof(glm::vec4)), staging.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    glActiveTexture(GL_TEXTURE0 + DRAW_DATA_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void DrawDataRing::endFrame() {
+    if (mapped)
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region + 1) % regionCount;
+}
+
+bool DrawDataRing::isPersistent() const {
+    return mapped != nullptr;
+}
+
+void DrawDataRing::cleanup() {
+    for (GLsync &fence: fences) {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (mapped) {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glUnmapBuffer(GL_TEXTURE_BUFFER);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        mapped = nullptr;
+    }
+    if (texture != 0) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+    if (buffer != 0) {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef DRAWDATARING_H
+#define DRAWDATARING_H
+#include <vector>
+#include <glm/glm.hpp>
+#include "glad/gl.h"
+
+// Texture unit of the drawData samplerBuffer, above the units used by the passes
+#define DRAW_DATA_TEXTURE_UNIT 7
+
+// Texture unit of the materials samplerBuffer, the material table of the object being drawn
+#define MATERIAL_TABLE_TEXTURE_UNIT 8
+
+// Number of frames the GPU may lag behind: one region of the ring per frame in flight
+#define DRAW_DATA_FRAME_REGIONS 3
+
+// Texel layout, mirrored in shaders/common/draw_data.glsl:
+//  object header: model matrix (4 texels), (first joint matrix texel or -1, 0, 0, 0),
+//                 normal matrix of the model (3 texels, the columns of its inverse transpose)
+//  joint matrices: 4 texels each, right after the header of skinned objects
+//  draw record: (object header texel, material or -1, first index in the object's vertex fetch buffers or -1, 0)
+// drawID is the texel of a draw record. Materials are read from the material table of the object.
+#define OBJECT_DATA_TEXELS 8
+#define DRAW_RECORD_TEXELS 1
+
+inline void writeObjectData(glm::vec4 *data, const glm::mat4 &model, const int firstJoint) {
+    for (int i = 0; i < 4; i++)
+        data[i] = model[i];
+    data[4] = glm::vec4(static_cast<float>(firstJoint), 0.0f, 0.0f, 0.0f);
+    const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+    for (int i = 0; i < 3; i++)
+        data[5 + i] = glm::vec4(normalMatrix[i], 0.0f);
+}
+
+inline void writeDrawRecord(glm::vec4 *data, const int object, const int material, const int firstIndex) {
+    data[0] = glm::vec4(static_cast<float>(object), static_cast<float>(material), static_cast<float>(firstIndex),
+                        0.0f);
+}
+
+// Per-draw constants of a frame (model matrices, joint matrices, material indices) packed as RGBA32F texels in a
+// texture buffer that the shaders read with texelFetch(drawData, drawID). The buffer is split in one region per
+// frame in flight, each guarded by a fence. With GL_ARB_buffer_storage it is persistently mapped and written
+// with plain stores; otherwise the frame is staged on the CPU and uploaded with one orphaning glBufferData.
+class DrawDataRing {
+    GLuint buffer = 0;
+    GLuint texture = 0;
+
+    size_t regionTexels;
+    int regionCount = DRAW_DATA_FRAME_REGIONS;
+    int region = 0;
+    size_t used = 0;
+    GLsync fences[DRAW_DATA_FRAME_REGIONS] = {};
+
+    glm::vec4 *mapped = nullptr;
+    std::vector<glm::vec4> staging;
+    std::vector<glm::vec4> overflow;
+    bool overflowReported = false;
+
+public:
+    explicit DrawDataRing(size_t texelsPerFrame);
+
+    // The 3.3 loader does not know glBufferStorage, it is fetched through `load` when the driver has it
+    void setup(GLADloadfunc load);
+
+    // Waits until the GPU is done with the region of this frame
+    void beginFrame();
+
+    // Reserves `texels` texels for this frame. Returns their index in the texture buffer and where to write them.
+    int allocate(int texels, glm::vec4 *&data);
+
+    // Makes the frame's data visible to the GPU, to call before the draws that read it
+    void flush();
+
+    // Fences the region of this frame, to call once every pass has been submitted
+    void endFrame();
+
+    [[nodiscard]] bool isPersistent() const;
+
+    void cleanup();
+};
+
+#endif //DRAWDATARING_H
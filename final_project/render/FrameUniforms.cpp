@@ -0,0 +1,139 @@
+#include "FrameUniforms.h"
+
+#include <cstring>
+#include "UniformBlocks.h"
+
+FrameUniforms::FrameUniforms(const int width, const int height, std::vector<Light *> &lights) : width(width),
+    height(height), lights(lights) {
+}
+
+void FrameUniforms::setup() {
+    // Views are bound with glBindBufferRange, so each one starts on the required alignment
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    viewStride = static_cast<GLint>((sizeof(viewUniformsStruct) + alignment - 1) / alignment * alignment);
+    resizeViews();
+
+    glGenBuffers(1, &frameUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(frameUniformsStruct), nullptr, GL_DYNAMIC_DRAW);
+
+    glGenBuffers(1, &viewsUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, viewsUBO);
+    glBufferData(GL_UNIFORM_BUFFER, static_cast<long long>(viewsData.size()), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    frameData.viewport = glm::vec4(width, height, 1.0f / static_cast<float>(width),
+                                   1.0f / static_cast<float>(height));
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, frameUBO);
+    bindView(0);
+}
+
+void FrameUniforms::setSSAOKernel(const std::vector<glm::vec3> &kernel) {
+    for (int i = 0; i < kernel.size() && i < 64; i++)
+        frameData.ssaoSamples[i] = glm::vec4(kernel[i], 0.0f);
+}
+
+void FrameUniforms::setShadowFilter(const bool moments, const float level) {
+    frameData.shadowFilter = glm::vec4(moments ? 1.0f : 0.0f, level, 0.0f, 0.0f);
+}
+
+void FrameUniforms::setDistanceField(const bool traced, const glm::vec3 min, const glm::vec3 max,
+                                     const float voxelSize, const float softness) {
+    frameData.distanceField = glm::vec4(traced ? 1.0f : 0.0f, voxelSize, softness, 0.0f);
+    frameData.distanceFieldMin = glm::vec4(min, 0.0f);
+    frameData.distanceFieldMax = glm::vec4(max, 0.0f);
+}
+
+void FrameUniforms::resizeViews() {
+    const size_t size = viewStride * (lights.size() + 1 + CSM_CASCADES);
+    if (viewsData.size() != size)
+        viewsData.assign(size, 0);
+}
+
+void FrameUniforms::writeView(const int view, const ViewPoint &viewPoint) {
+    writeView(view, viewPoint.getViewMatrix(), viewPoint.getProjectionMatrix(), viewPoint.getPosition());
+}
+
+void FrameUniforms::writeView(const int view, const glm::mat4 &viewMatrix, const glm::mat4 &projection,
+                              const glm::vec3 position) {
+    viewUniformsStruct data;
+    data.view = viewMatrix;
+    data.projection = projection;
+    data.viewProjection = data.projection * data.view;
+    data.position = glm::vec4(position, 1.0f);
+    std::memcpy(&viewsData[view * viewStride], &data, sizeof(data));
+}
+
+void FrameUniforms::update(const Camera &camera, const float time, const float deltaTime) {
+    frameData.view = camera.getViewMatrix();
+    frameData.projection = camera.getProjectionMatrix();
+    frameData.inverseView = glm::inverse(frameData.view);
+    frameData.inverseProjection = glm::inverse(frameData.projection);
+    frameData.time = glm::vec4(time, deltaTime, 0.0f, 0.0f);
+
+    // Lights may have been added since the last frame, the upload below reallocates the buffer to the new size
+    resizeViews();
+    writeView(0, camera);
+    for (int i = 0; i < lights.size(); i++)
+        writeView(getLightView(i), *lights[i]);
+
+    cascadeLight = findCascadeLight(lights);
+    frameData.cascadeLight = glm::ivec4(cascadeLight, 0, 0, 0);
+    if (cascadeLight >= 0) {
+        const auto *light = static_cast<const DirectionalLight *>(lights[cascadeLight]);
+        for (int c = 0; c < CSM_CASCADES; c++) {
+            frameData.cascadeMatrices[c] = light->getCascadeMatrix(c);
+            frameData.cascadeSplits[c] = light->getCascadeSplit(c);
+            writeView(getCascadeView(c), light->getCascadeView(c), light->getCascadeProjection(c),
+                      light->getPosition());
+        }
+    }
+
+    // Orphan the previous contents so the upload does not wait on last frame's draws
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(frameUniformsStruct), &frameData, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, viewsUBO);
+    glBufferData(GL_UNIFORM_BUFFER, static_cast<long long>(viewsData.size()), viewsData.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, frameUBO);
+    bindView(0);
+}
+
+void FrameUniforms::bindView(const int view) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, VIEW_BLOCK_BINDING, viewsUBO, view * viewStride,
+                      sizeof(viewUniformsStruct));
+}
+
+int FrameUniforms::getLightView(const int light) {
+    return light + 1;
+}
+
+int FrameUniforms::getCascadeView(const int cascade) const {
+    return static_cast<int>(lights.size()) + 1 + cascade;
+}
+
+int FrameUniforms::findCascadeLight(const std::vector<Light *> &lights) {
+    for (int i = 0; i < lights.size(); i++) {
+        if (lights[i]->getType() == DIRECTIONAL_LIGHT)
+            return i;
+    }
+    return -1;
+}
+
+int FrameUniforms::getCascadeLight() const {
+    return cascadeLight;
+}
+
+void FrameUniforms::cleanup() {
+    if (frameUBO != 0) {
+        glDeleteBuffers(1, &frameUBO);
+        frameUBO = 0;
+    }
+    if (viewsUBO != 0) {
+        glDeleteBuffers(1, &viewsUBO);
+        viewsUBO = 0;
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef FRAMEUNIFORMS_H
+#define FRAMEUNIFORMS_H
+#include <vector>
+#include <glm/glm.hpp>
+#include "glad/gl.h"
+#include "view_points/camera/camera.h"
+#include "view_points/lights/light/Light.h"
+#include "view_points/lights/directional_light/DirectionalLight.h"
+
+// std140 layout of the FrameUniforms block (shaders/common/uniform_blocks.glsl)
+struct frameUniformsStruct {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 inverseView;
+    glm::mat4 inverseProjection;
+    glm::vec4 viewport;
+    glm::vec4 time;
+    glm::vec4 ssaoSamples[64];
+    glm::mat4 cascadeMatrices[CSM_CASCADES];
+    glm::vec4 cascadeSplits;
+    glm::ivec4 cascadeLight;
+    glm::vec4 shadowFilter;
+    glm::vec4 distanceField;
+    glm::vec4 distanceFieldMin;
+    glm::vec4 distanceFieldMax;
+};
+
+// std140 layout of the ViewUniforms block
+struct viewUniformsStruct {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 position;
+};
+
+// Owns the per-frame block and one per-view block for the camera, each light and each shadow cascade. Both are
+// written once per frame, before the passes run, and bound at the fixed binding points of render/UniformBlocks.h.
+// The cascades are those of the first directional light, the only one casting shadows.
+class FrameUniforms {
+    GLuint frameUBO = 0;
+    GLuint viewsUBO = 0;
+    GLint viewStride = 0;
+
+    int width, height;
+    std::vector<Light *> &lights;
+
+    frameUniformsStruct frameData{};
+    std::vector<unsigned char> viewsData;
+
+    int cascadeLight = -1;
+
+    // Sizes viewsData for the camera, the current lights and the cascades
+    void resizeViews();
+
+    void writeView(int view, const ViewPoint &viewPoint);
+
+    void writeView(int view, const glm::mat4 &viewMatrix, const glm::mat4 &projection, glm::vec3 position);
+
+public:
+    FrameUniforms(int width, int height, std::vector<Light *> &lights);
+
+    void setup();
+
+    void setSSAOKernel(const std::vector<glm::vec3> &kernel);
+
+    // Whether the lighting reads the filtered moments of the shadow maps, and at which mip level
+    void setShadowFilter(bool moments, float level);
+
+    // Whether the lighting traces the static casters through the distance field, and where the field is
+    void setDistanceField(bool traced, glm::vec3 min, glm::vec3 max, float voxelSize, float softness);
+
+    void update(const Camera &camera, float time, float deltaTime);
+
+    // View 0 is the camera, view i + 1 is lights[i]
+    void bindView(int view) const;
+
+    static int getLightView(int light);
+
+    [[nodiscard]] int getCascadeView(int cascade) const;
+
+    // Index of the light whose cascades are in the blocks, -1 if there is no directional light
+    [[nodiscard]] int getCascadeLight() const;
+
+    // The first directional light, whose cascades the blocks hold
+    [[nodiscard]] static int findCascadeLight(const std::vector<Light *> &lights);
+
+    void cleanup();
+};
+
+#endif //FRAMEUNIFORMS_H
@@ -0,0 +1,24 @@
+#include "Frustum.h"
+
+Frustum::Frustum(const glm::mat4 &matrix) {
+    // Rows of the matrix, -w <= x, y, z <= w in clip space
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+
+    for (int axis = 0; axis < 3; axis++) {
+        planes[2 * axis] = rows[3] + rows[axis];
+        planes[2 * axis + 1] = rows[3] - rows[axis];
+    }
+}
+
+bool Frustum::intersects(const glm::vec3 &min, const glm::vec3 &max) const {
+    for (const glm::vec4 &plane: planes) {
+        // Corner of the box furthest along the plane normal
+        const glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y,
+                               plane.z >= 0.0f ? max.z : min.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,17 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+#include <glm/glm.hpp>
+
+// The six planes of a view projection, facing inwards, in the space the matrix transforms from. Works the same for
+// perspective and orthographic projections.
+class Frustum {
+    glm::vec4 planes[6];
+
+public:
+    explicit Frustum(const glm::mat4 &matrix);
+
+    // Whether a box may be inside the frustum. Boxes near a corner may pass without being inside.
+    [[nodiscard]] bool intersects(const glm::vec3 &min, const glm::vec3 &max) const;
+};
+
+#endif //FRUSTUM_H
@@ -0,0 +1,83 @@
+#include "LightBuffer.h"
+
+#include <algorithm>
+
+void LightBuffer::setup(const size_t initialCapacity) {
+    glGenBuffers(1, &buffer);
+    glGenTextures(1, &texture);
+    reserve(std::max<size_t>(initialCapacity, 1));
+}
+
+void LightBuffer::reserve(const size_t lightCount) {
+    if (lightCount <= capacity)
+        return;
+
+    // Grow geometrically, the contents are uploaded again right after
+    capacity = std::max(lightCount, capacity * 2);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(capacity * sizeof(lightStruct)), nullptr,
+                 GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    uploadedLights.clear();
+    uploadedVersions.clear();
+}
+
+int LightBuffer::update(const std::vector<Light *> &lights) {
+    reserve(lights.size());
+    structs.resize(lights.size());
+    uploadedLights.resize(lights.size(), nullptr);
+    uploadedVersions.resize(lights.size(), 0);
+
+    // Contiguous range of the rebuilt lights, uploaded with a single call
+    size_t first = lights.size();
+    size_t last = 0;
+    for (size_t i = 0; i < lights.size(); i++) {
+        if (uploadedLights[i] == lights[i] && uploadedVersions[i] == lights[i]->getVersion())
+            continue;
+
+        structs[i] = lights[i]->toStruct();
+        uploadedLights[i] = lights[i];
+        uploadedVersions[i] = lights[i]->getVersion();
+        first = std::min(first, i);
+        last = i;
+    }
+
+    if (first > last)
+        return 0;
+
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, static_cast<GLintptr>(first * sizeof(lightStruct)),
+                    static_cast<GLsizeiptr>((last - first + 1) * sizeof(lightStruct)), &structs[first]);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    return static_cast<int>(last - first + 1);
+}
+
+void LightBuffer::bind(const int unit) const {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+int LightBuffer::getLightCount() const {
+    return static_cast<int>(structs.size());
+}
+
+void LightBuffer::cleanup() {
+    if (texture != 0) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+    if (buffer != 0) {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    capacity = 0;
+    structs.clear();
+    uploadedLights.clear();
+    uploadedVersions.clear();
+}
@@ -0,0 +1,39 @@
+#ifndef LIGHTBUFFER_H
+#define LIGHTBUFFER_H
+#include <vector>
+#include "glad/gl.h"
+#include "view_points/lights/light/Light.h"
+
+// Texture unit of the lightData samplerBuffer in the programs that shade with the lights
+#define LIGHTS_TEXTURE_UNIT 9
+
+// RGBA32F texels per light, a lightStruct copied as is (shaders/common/lights.glsl)
+#define LIGHT_TEXELS (sizeof(lightStruct) / sizeof(glm::vec4))
+
+// Every light of the scene in a texture buffer (GL 3.3 has no SSBOs), read with texelFetch(lightData, ...).
+// The buffer grows with the light count and a light is only rebuilt and uploaded again when its version changed.
+class LightBuffer {
+    GLuint buffer = 0;
+    GLuint texture = 0;
+    size_t capacity = 0;
+
+    std::vector<lightStruct> structs;
+    std::vector<const Light *> uploadedLights;
+    std::vector<unsigned int> uploadedVersions;
+
+    void reserve(size_t lightCount);
+
+public:
+    void setup(size_t initialCapacity);
+
+    // Uploads the lights that changed since the last call, returns the number of lights uploaded
+    int update(const std::vector<Light *> &lights);
+
+    void bind(int unit) const;
+
+    [[nodiscard]] int getLightCount() const;
+
+    void cleanup();
+};
+
+#endif //LIGHTBUFFER_H
@@ -0,0 +1,226 @@
+#include "LightClusters.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LIGHT_CLUSTERS_SSE
+#endif
+
+LightClusters::LightClusters(const int width, const int height) : width(width), height(height) {
+    tilesX = (width + CLUSTER_TILE_SIZE - 1) / CLUSTER_TILE_SIZE;
+    tilesY = (height + CLUSTER_TILE_SIZE - 1) / CLUSTER_TILE_SIZE;
+    clustersPerSlice = tilesX * tilesY;
+    paddedClustersPerSlice = (clustersPerSlice + 3) / 4 * 4;
+}
+
+void LightClusters::setup(const ViewPoint &camera) {
+    const float near = camera.getNear();
+    const float far = camera.getFar();
+    sliceScale = static_cast<float>(CLUSTER_DEPTH_SLICES) / std::log(far / near);
+    sliceBias = -std::log(near) * sliceScale;
+
+    sliceDepths.resize(CLUSTER_DEPTH_SLICES + 1);
+    for (int i = 0; i <= CLUSTER_DEPTH_SLICES; i++)
+        sliceDepths[i] = near * std::pow(far / near, static_cast<float>(i) / CLUSTER_DEPTH_SLICES);
+
+    buildClusterBounds(camera.getProjectionMatrix());
+
+    const int clusterCount = clustersPerSlice * CLUSTER_DEPTH_SLICES;
+    clusterLights.resize(clusterCount);
+    offsets.assign(2 * clusterCount, 0);
+
+    glGenBuffers(1, &offsetsBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, offsetsBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(offsets.size() * sizeof(GLint)), nullptr,
+                 GL_STREAM_DRAW);
+    glGenBuffers(1, &indicesBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, indicesBuffer);
+    indicesCapacity = clusterCount;
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(indicesCapacity * sizeof(GLint)), nullptr,
+                 GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &offsetsTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, offsetsTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32I, offsetsBuffer);
+    glGenTextures(1, &indicesTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, indicesTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32I, indicesBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::buildClusterBounds(const glm::mat4 &projection) {
+    clusterProjection = projection;
+    const glm::mat4 inverseProjection = glm::inverse(projection);
+    const size_t size = static_cast<size_t>(paddedClustersPerSlice) * CLUSTER_DEPTH_SLICES;
+
+    // Padding clusters are empty boxes far behind the camera, no sphere reaches them
+    minX.assign(size, 0.0f);
+    minY.assign(size, 0.0f);
+    minZ.assign(size, 1e30f);
+    maxX.assign(size, 0.0f);
+    maxY.assign(size, 0.0f);
+    maxZ.assign(size, 1e30f);
+
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            // Rays through the corners of the tile, scaled to a view depth of 1
+            glm::vec3 rays[4];
+            for (int corner = 0; corner < 4; corner++) {
+                const int px = std::min((tx + (corner & 1)) * CLUSTER_TILE_SIZE, width);
+                const int py = std::min((ty + (corner >> 1)) * CLUSTER_TILE_SIZE, height);
+                const glm::vec4 ndc(2.0f * static_cast<float>(px) / static_cast<float>(width) - 1.0f,
+                                    2.0f * static_cast<float>(py) / static_cast<float>(height) - 1.0f, -1.0f, 1.0f);
+                glm::vec4 nearPoint = inverseProjection * ndc;
+                nearPoint /= nearPoint.w;
+                rays[corner] = glm::vec3(nearPoint) / -nearPoint.z;
+            }
+
+            for (int slice = 0; slice < CLUSTER_DEPTH_SLICES; slice++) {
+                glm::vec3 boundsMin(1e30f);
+                glm::vec3 boundsMax(-1e30f);
+                for (const glm::vec3 &ray: rays) {
+                    for (const float depth: {sliceDepths[slice], sliceDepths[slice + 1]}) {
+                        boundsMin = glm::min(boundsMin, ray * depth);
+                        boundsMax = glm::max(boundsMax, ray * depth);
+                    }
+                }
+
+                const size_t i = static_cast<size_t>(slice) * paddedClustersPerSlice + ty * tilesX + tx;
+                minX[i] = boundsMin.x;
+                minY[i] = boundsMin.y;
+                minZ[i] = boundsMin.z;
+                maxX[i] = boundsMax.x;
+                maxY[i] = boundsMax.y;
+                maxZ[i] = boundsMax.z;
+            }
+        }
+    }
+}
+
+void LightClusters::assignSlices(const int firstSlice, const int lastSlice, const std::vector<glm::vec4> &spheres) {
+    for (int slice = firstSlice; slice <= lastSlice; slice++) {
+        for (int c = 0; c < clustersPerSlice; c++)
+            clusterLights[slice * clustersPerSlice + c].clear();
+
+        const size_t base = static_cast<size_t>(slice) * paddedClustersPerSlice;
+        for (int light = 0; light < spheres.size(); light++) {
+            const glm::vec4 &sphere = spheres[light];
+
+            // The camera looks down -z
+            if (-sphere.z + sphere.w < sliceDepths[slice] || -sphere.z - sphere.w > sliceDepths[slice + 1])
+                continue;
+
+#ifdef LIGHT_CLUSTERS_SSE
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 cx = _mm_set1_ps(sphere.x);
+            const __m128 cy = _mm_set1_ps(sphere.y);
+            const __m128 cz = _mm_set1_ps(sphere.z);
+            const __m128 radius2 = _mm_set1_ps(sphere.w * sphere.w);
+
+            for (int c = 0; c < paddedClustersPerSlice; c += 4) {
+                const size_t i = base + c;
+                // Distance from the center to the box, per axis: max(min - center, center - max, 0)
+                const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minX[i]), cx),
+                                                        _mm_sub_ps(cx, _mm_loadu_ps(&maxX[i]))), zero);
+                const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minY[i]), cy),
+                                                        _mm_sub_ps(cy, _mm_loadu_ps(&maxY[i]))), zero);
+                const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minZ[i]), cz),
+                                                        _mm_sub_ps(cz, _mm_loadu_ps(&maxZ[i]))), zero);
+                const __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                                    _mm_mul_ps(dz, dz));
+
+                const int mask = _mm_movemask_ps(_mm_cmple_ps(distance2, radius2));
+                if (mask == 0)
+                    continue;
+                for (int lane = 0; lane < 4 && c + lane < clustersPerSlice; lane++) {
+                    if (mask & (1 << lane))
+                        clusterLights[slice * clustersPerSlice + c + lane].push_back(light);
+                }
+            }
+#else
+            for (int c = 0; c < clustersPerSlice; c++) {
+                const size_t i = base + c;
+                const float dx = std::max(std::max(minX[i] - sphere.x, sphere.x - maxX[i]), 0.0f);
+                const float dy = std::max(std::max(minY[i] - sphere.y, sphere.y - maxY[i]), 0.0f);
+                const float dz = std::max(std::max(minZ[i] - sphere.z, sphere.z - maxZ[i]), 0.0f);
+                if (dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w)
+                    clusterLights[slice * clustersPerSlice + c].push_back(light);
+            }
+#endif
+        }
+    }
+}
+
+void LightClusters::update(const Camera &camera, const std::vector<Light *> &lights) {
+    if (camera.getProjectionMatrix() != clusterProjection)
+        buildClusterBounds(camera.getProjectionMatrix());
+
+    const glm::mat4 view = camera.getViewMatrix();
+    std::vector<glm::vec4> spheres(lights.size());
+    for (size_t i = 0; i < lights.size(); i++)
+        spheres[i] = glm::vec4(glm::vec3(view * glm::vec4(lights[i]->getPosition(), 1.0f)), lights[i]->getRange());
+
+    // Each job owns a contiguous range of slices, so the cluster lists are never shared
+    WorkerPool &pool = WorkerPool::shared();
+    const int jobCount = lights.size() < CLUSTER_THREADED_LIGHTS ? 1 : pool.getThreadCount();
+    const int slicesPerJob = (CLUSTER_DEPTH_SLICES + jobCount - 1) / jobCount;
+    pool.run((CLUSTER_DEPTH_SLICES + slicesPerJob - 1) / slicesPerJob, [&](const int job) {
+        const int first = job * slicesPerJob;
+        assignSlices(first, std::min(first + slicesPerJob, CLUSTER_DEPTH_SLICES) - 1, spheres);
+    });
+
+    indices.clear();
+    for (size_t c = 0; c < clusterLights.size(); c++) {
+        offsets[2 * c] = static_cast<GLint>(indices.size());
+        offsets[2 * c + 1] = static_cast<GLint>(clusterLights[c].size());
+        indices.insert(indices.end(), clusterLights[c].begin(), clusterLights[c].end());
+    }
+
+    // Both buffers are orphaned, the lighting pass of the previous frame may still read them
+    glBindBuffer(GL_TEXTURE_BUFFER, offsetsBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(offsets.size() * sizeof(GLint)), offsets.data(),
+                 GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, indicesBuffer);
+    indicesCapacity = std::max(indicesCapacity, indices.size());
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(indicesCapacity * sizeof(GLint)), nullptr,
+                 GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, static_cast<GLsizeiptr>(indices.size() * sizeof(GLint)), indices.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::bind() const {
+    glActiveTexture(GL_TEXTURE0 + CLUSTER_OFFSETS_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, offsetsTexture);
+    glActiveTexture(GL_TEXTURE0 + CLUSTER_LIGHTS_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, indicesTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+glm::ivec4 LightClusters::getGrid() const {
+    return {tilesX, tilesY, CLUSTER_DEPTH_SLICES, CLUSTER_TILE_SIZE};
+}
+
+glm::vec2 LightClusters::getSlicing() const {
+    return {sliceScale, sliceBias};
+}
+
+size_t LightClusters::getAssignmentCount() const {
+    return indices.size();
+}
+
+void LightClusters::cleanup() {
+    for (GLuint *texture: {&offsetsTexture, &indicesTexture}) {
+        if (*texture != 0)
+            glDeleteTextures(1, texture);
+        *texture = 0;
+    }
+    for (GLuint *buffer: {&offsetsBuffer, &indicesBuffer}) {
+        if (*buffer != 0)
+            glDeleteBuffers(1, buffer);
+        *buffer = 0;
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef LIGHTCLUSTERS_H
+#define LIGHTCLUSTERS_H
+#include <vector>
+#include <glm/glm.hpp>
+#include "glad/gl.h"
+#include "view_points/camera/camera.h"
+#include "view_points/lights/light/Light.h"
+
+// Screen tiles of CLUSTER_TILE_SIZE² pixels, times exponential depth slices between the camera near and far planes
+#define CLUSTER_TILE_SIZE 64
+#define CLUSTER_DEPTH_SLICES 24
+
+// Texture units of the clusterOffsets and clusterLights samplerBuffers (shaders/common/clusters.glsl)
+#define CLUSTER_OFFSETS_TEXTURE_UNIT 10
+#define CLUSTER_LIGHTS_TEXTURE_UNIT 11
+
+// Below this many lights the assignment stays on the calling thread, waking the workers would cost more
+#define CLUSTER_THREADED_LIGHTS 32
+
+// Assigns the lights to the clusters of the camera frustum they can reach, every frame on the CPU. Each light is a
+// sphere of radius Light::getRange() tested against the view space bounds of the clusters, four at a time with
+// SSE when available, and the depth slices are split across WorkerPool::shared() when there are enough lights.
+// The result is an (offset, count) pair per cluster and a flat list of light indices, both in integer texture
+// buffers.
+class LightClusters {
+    int width, height;
+    int tilesX, tilesY;
+    int clustersPerSlice;
+    // Clusters of a slice, rounded up to a multiple of 4 for the SIMD loop
+    int paddedClustersPerSlice;
+
+    // slice = log(view depth) * sliceScale + sliceBias
+    float sliceScale = 0;
+    float sliceBias = 0;
+    std::vector<float> sliceDepths;
+
+    // View space bounds of every cluster, structure of arrays
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+
+    std::vector<std::vector<GLint> > clusterLights;
+    std::vector<GLint> offsets;
+    std::vector<GLint> indices;
+
+    GLuint offsetsBuffer = 0;
+    GLuint offsetsTexture = 0;
+    GLuint indicesBuffer = 0;
+    GLuint indicesTexture = 0;
+    size_t indicesCapacity = 0;
+
+    // Projection the cluster bounds were built for
+    glm::mat4 clusterProjection = glm::mat4(0.0f);
+
+    void buildClusterBounds(const glm::mat4 &projection);
+
+    // Spheres are the view space position and range of the lights
+    void assignSlices(int firstSlice, int lastSlice, const std::vector<glm::vec4> &spheres);
+
+public:
+    LightClusters(int width, int height);
+
+    // The slices follow the camera near and far planes, the tiles its projection, rebuilt by update() when it changes
+    void setup(const ViewPoint &camera);
+
+    void update(const Camera &camera, const std::vector<Light *> &lights);
+
+    void bind() const;
+
+    // Tiles x, tiles y, depth slices, tile size in pixels
+    [[nodiscard]] glm::ivec4 getGrid() const;
+
+    // Scale and bias from log(view depth) to the depth slice
+    [[nodiscard]] glm::vec2 getSlicing() const;
+
+    // Light indices of the last update, summed over all clusters
+    [[nodiscard]] size_t getAssignmentCount() const;
+
+    void cleanup();
+};
+
+#endif //LIGHTCLUSTERS_H
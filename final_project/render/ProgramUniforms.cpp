@@ -0,0 +1,140 @@
+#include "ProgramUniforms.h"
+#include "UniformBlocks.h"
+
+#include <algorithm>
+#include <iostream>
+
+// Objects are rendered many times in a row with the same program
+static ProgramUniforms *lastProgram = nullptr;
+
+static std::vector<std::string> &internedNames() {
+    static std::vector<std::string> names;
+    return names;
+}
+
+static std::unordered_map<std::string, int> &internedIDs() {
+    static std::unordered_map<std::string, int> ids;
+    return ids;
+}
+
+UniformName::UniformName(const char *name) {
+    const auto [it, inserted] = internedIDs().emplace(name, static_cast<int>(internedNames().size()));
+    if (inserted)
+        internedNames().emplace_back(name);
+    id = it->second;
+}
+
+int UniformName::getID() const {
+    return id;
+}
+
+const std::string &UniformName::getName() const {
+    return internedNames()[id];
+}
+
+ProgramUniforms::ProgramUniforms(const GLuint programID) : programID(programID) {
+    GLint uniformCount = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<char> name(std::max(maxNameLength, 1));
+    slots.reserve(uniformCount);
+    for (GLuint i = 0; i < uniformCount; i++) {
+        UniformSlot slot;
+        GLsizei length = 0;
+        glGetActiveUniform(programID, i, static_cast<GLsizei>(name.size()), &length, &slot.size, &slot.type,
+                           name.data());
+        std::string uniformName(name.data(), length);
+
+        // Members of uniform blocks have no location
+        slot.location = glGetUniformLocation(programID, uniformName.c_str());
+        if (slot.location < 0)
+            continue;
+
+        // Arrays are reported as "name[0]", make them reachable by "name" too
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+            slotIndices[uniformName.substr(0, uniformName.size() - 3)] = static_cast<int>(slots.size());
+        slotIndices[uniformName] = static_cast<int>(slots.size());
+        slots.push_back(slot);
+    }
+
+    GLint blockCount = 0;
+    GLint maxBlockNameLength = 0;
+    glGetProgramiv(programID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    glGetProgramiv(programID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockNameLength);
+
+    name.resize(std::max(maxBlockNameLength, 1));
+    for (GLuint i = 0; i < blockCount; i++) {
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(programID, i, static_cast<GLsizei>(name.size()), &length, name.data());
+
+        Block block{};
+        block.index = i;
+        glGetActiveUniformBlockiv(programID, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.dataSize);
+
+        std::string blockName(name.data(), length);
+        if (const auto binding = uniformBlockBindings.find(blockName); binding != uniformBlockBindings.end())
+            glUniformBlockBinding(programID, i, binding->second);
+        blocks[blockName] = block;
+    }
+}
+
+std::unordered_map<GLuint, std::unique_ptr<ProgramUniforms> > &ProgramUniforms::programs() {
+    static std::unordered_map<GLuint, std::unique_ptr<ProgramUniforms> > programs;
+    return programs;
+}
+
+void ProgramUniforms::reflect(const GLuint programID) {
+    if (programID == 0)
+        return;
+    lastProgram = nullptr;
+    programs()[programID] = std::make_unique<ProgramUniforms>(programID);
+}
+
+ProgramUniforms &ProgramUniforms::get(const GLuint programID) {
+    if (lastProgram && lastProgram->programID == programID)
+        return *lastProgram;
+
+    auto &program = programs()[programID];
+    if (!program) {
+        std::cerr << "Program " << programID << " was not reflected after linking" << std::endl;
+        program = std::make_unique<ProgramUniforms>(programID);
+    }
+    lastProgram = program.get();
+    return *lastProgram;
+}
+
+int ProgramUniforms::findSlot(const UniformName &name) {
+    if (name.getID() >= slotsByName.size())
+        slotsByName.resize(name.getID() + 1, -2);
+
+    int &slot = slotsByName[name.getID()];
+    if (slot == -2) {
+        const auto it = slotIndices.find(name.getName());
+        slot = it != slotIndices.end() ? it->second : -1;
+    }
+    return slot;
+}
+
+int ProgramUniforms::findSlot(const std::string &name) const {
+    const auto it = slotIndices.find(name);
+    return it != slotIndices.end() ? it->second : -1;
+}
+
+UniformSlot *ProgramUniforms::getSlot(const int index) {
+    return index >= 0 && index < slots.size() ? &slots[index] : nullptr;
+}
+
+GLuint ProgramUniforms::getBlockIndex(const std::string &name) const {
+    const auto it = blocks.find(name);
+    return it != blocks.end() ? it->second.index : GL_INVALID_INDEX;
+}
+
+const std::unordered_map<std::string, ProgramUniforms::Block> &ProgramUniforms::getBlocks() const {
+    return blocks;
+}
+
+GLuint ProgramUniforms::getProgramID() const {
+    return programID;
+}
@@ -0,0 +1,162 @@
+#ifndef PROGRAMUNIFORMS_H
+#define PROGRAMUNIFORMS_H
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "glad/gl.h"
+
+// Name of a uniform interned once, when it is declared (usually as a static). Looking it up in a program is
+// then an index into a table instead of a string hash or a glGetUniformLocation.
+class UniformName {
+    int id;
+
+    public:
+        explicit UniformName(const char *name);
+
+        [[nodiscard]] int getID() const;
+        [[nodiscard]] const std::string &getName() const;
+};
+
+// Last value uploaded to a uniform of a program, shared by every handle on that uniform
+struct UniformSlot {
+    GLint location = -1;
+    GLenum type = 0;
+    GLint size = 0;
+    std::vector<unsigned char> value;
+
+    // Returns true if the value differs from the last upload, and remembers it
+    bool update(const void *data, size_t bytes) {
+        if (value.size() == bytes && std::memcmp(value.data(), data, bytes) == 0)
+            return false;
+        value.assign(static_cast<const unsigned char *>(data), static_cast<const unsigned char *>(data) + bytes);
+        return true;
+    }
+};
+
+inline void uploadUniform(const GLint location, const int *values, const int count) {
+    glUniform1iv(location, count, values);
+}
+
+inline void uploadUniform(const GLint location, const glm::ivec2 *values, const int count) {
+    glUniform2iv(location, count, glm::value_ptr(values[0]));
+}
+
+inline void uploadUniform(const GLint location, const glm::ivec4 *values, const int count) {
+    glUniform4iv(location, count, glm::value_ptr(values[0]));
+}
+
+inline void uploadUniform(const GLint location, const float *values, const int count) {
+    glUniform1fv(location, count, values);
+}
+
+inline void uploadUniform(const GLint location, const glm::vec2 *values, const int count) {
+    glUniform2fv(location, count, glm::value_ptr(values[0]));
+}
+
+inline void uploadUniform(const GLint location, const glm::vec3 *values, const int count) {
+    glUniform3fv(location, count, glm::value_ptr(values[0]));
+}
+
+inline void uploadUniform(const GLint location, const glm::vec4 *values, const int count) {
+    glUniform4fv(location, count, glm::value_ptr(values[0]));
+}
+
+inline void uploadUniform(const GLint location, const glm::mat4 *values, const int count) {
+    glUniformMatrix4fv(location, count, GL_FALSE, glm::value_ptr(values[0]));
+}
+
+template<typename T>
+class Uniform;
+
+// Active uniforms and uniform blocks of a linked program, enumerated once after linking. Blocks listed in
+// render/UniformBlocks.h are bound to their fixed binding point at that time.
+class ProgramUniforms {
+    public:
+        struct Block {
+            GLuint index;
+            GLint dataSize;
+        };
+
+    private:
+        GLuint programID;
+
+        std::vector<UniformSlot> slots;
+        std::unordered_map<std::string, int> slotIndices;
+        std::unordered_map<std::string, Block> blocks;
+
+        // Slot of each interned name, -1 if the uniform is not active in this program, -2 if not looked up yet
+        std::vector<int> slotsByName;
+
+        static std::unordered_map<GLuint, std::unique_ptr<ProgramUniforms> > &programs();
+
+        // Index of the slot, -1 if the uniform is not active
+        int findSlot(const UniformName &name);
+
+        [[nodiscard]] int findSlot(const std::string &name) const;
+
+    public:
+        explicit ProgramUniforms(GLuint programID);
+
+        // Enumerates the uniforms of a freshly linked program
+        static void reflect(GLuint programID);
+
+        static ProgramUniforms &get(GLuint programID);
+
+        template<typename T>
+        Uniform<T> uniform(const UniformName &name) {
+            return Uniform<T>(programID, findSlot(name));
+        }
+
+        template<typename T>
+        Uniform<T> uniform(const std::string &name) {
+            return Uniform<T>(programID, findSlot(name));
+        }
+
+        // nullptr if the index is not one of this program's slots
+        [[nodiscard]] UniformSlot *getSlot(int index);
+
+        // GL_INVALID_INDEX if the block is not active
+        [[nodiscard]] GLuint getBlockIndex(const std::string &name) const;
+
+        [[nodiscard]] const std::unordered_map<std::string, Block> &getBlocks() const;
+
+        [[nodiscard]] GLuint getProgramID() const;
+};
+
+// Typed handle on an active uniform. Setting a value equal to the one already in the program is a no-op.
+// Like glUniform*, the program must be in use when calling set(). A handle on an inactive uniform does nothing.
+// The handle holds the index of the uniform's slot, not the slot itself, so it stays valid when the program is
+// reflected again.
+template<typename T>
+class Uniform {
+    GLuint programID = 0;
+    int slot = -1;
+
+    public:
+        Uniform() = default;
+
+        Uniform(const GLuint programID, const int slot) : programID(programID), slot(slot) {
+        }
+
+        [[nodiscard]] bool isActive() const {
+            return slot >= 0;
+        }
+
+        void set(const T &value) const {
+            set(&value, 1);
+        }
+
+        void set(const T *values, const int count) const {
+            if (slot < 0 || count <= 0)
+                return;
+            UniformSlot *uniformSlot = ProgramUniforms::get(programID).getSlot(slot);
+            if (uniformSlot && uniformSlot->update(values, sizeof(T) * count))
+                uploadUniform(uniformSlot->location, values, count);
+        }
+};
+
+#endif //PROGRAMUNIFORMS_H
@@ -0,0 +1,211 @@
+#include "ShadowAtlas.h"
+
+#include <algorithm>
+#include <numeric>
+
+QuadtreeAllocator::QuadtreeAllocator(const int size) {
+    nodes.push_back({0, 0, size});
+}
+
+void QuadtreeAllocator::reset() {
+    nodes.resize(1);
+    nodes[0].firstChild = -1;
+    nodes[0].used = false;
+}
+
+int QuadtreeAllocator::allocate(const int node, const int size) {
+    if (nodes[node].size < size || nodes[node].used)
+        return -1;
+
+    if (nodes[node].firstChild < 0) {
+        if (nodes[node].size == size) {
+            nodes[node].used = true;
+            return node;
+        }
+
+        // Split in four, the children are contiguous
+        const Node parent = nodes[node];
+        const int half = parent.size / 2;
+        nodes[node].firstChild = static_cast<int>(nodes.size());
+        nodes.push_back({parent.x, parent.y, half});
+        nodes.push_back({parent.x + half, parent.y, half});
+        nodes.push_back({parent.x, parent.y + half, half});
+        nodes.push_back({parent.x + half, parent.y + half, half});
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (const int found = allocate(nodes[node].firstChild + i, size); found >= 0)
+            return found;
+    }
+    return -1;
+}
+
+glm::ivec2 QuadtreeAllocator::allocate(const int size) {
+    const int node = allocate(0, size);
+    return node >= 0 ? glm::ivec2(nodes[node].x, nodes[node].y) : glm::ivec2(-1);
+}
+
+ShadowAtlas::ShadowAtlas() : allocator(SHADOW_ATLAS_SIZE) {
+}
+
+static GLuint createDepthTexture() {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE, 0,
+                 GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+void ShadowAtlas::setup() {
+    texture = createDepthTexture();
+    staticTexture = createDepthTexture();
+}
+
+float ShadowAtlas::getCoverage(const Camera &camera, const Light &light) {
+    const float distance = glm::length(light.getPosition() - camera.getPosition());
+    const float range = light.getRange();
+    if (distance <= range)
+        return 1.0f;
+    return std::min(1.0f, range / std::sqrt(distance * distance - range * range) *
+                          camera.getProjectionMatrix()[1][1]);
+}
+
+int ShadowAtlas::getRequestedSize(const Camera &camera, const Light &light) {
+    const float texels = static_cast<float>(SHADOW_TILE_MAX) * getCoverage(camera, light) *
+                         light.getShadowImportance();
+    int size = SHADOW_TILE_MIN;
+    while (size < texels && size < SHADOW_TILE_MAX)
+        size *= 2;
+    return size;
+}
+
+float ShadowAtlas::getContribution(const Camera &camera, const Light &light) {
+    const float coverage = getCoverage(camera, light);
+    const float luminance = glm::dot(light.getColor(), glm::vec3(0.2126f, 0.7152f, 0.0722f));
+    // Attenuated as in the shading, from the camera, directional lights have none
+    const float distance = glm::length(light.getPosition() - camera.getPosition());
+    const float irradiance = light.getType() == DIRECTIONAL_LIGHT
+                                 ? light.getIntensity()
+                                 : light.getIntensity() / std::max(distance * distance, 1.0f);
+    return coverage * coverage * luminance * irradiance * light.getShadowImportance();
+}
+
+void ShadowAtlas::updateFades(const Camera &camera, const std::vector<Light *> &lights, const float deltaTime) {
+    std::vector<float> contributions(lights.size());
+    for (size_t i = 0; i < lights.size(); i++)
+        contributions[i] = lights[i]->castsShadows() ? getContribution(camera, *lights[i]) : 0.0f;
+
+    std::vector<int> order(lights.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&contributions](const int a, const int b) {
+        return contributions[a] > contributions[b];
+    });
+
+    std::vector<bool> shadowed(lights.size(), false);
+    for (int rank = 0; rank < std::min(maxShadowedLights, static_cast<int>(order.size())); rank++)
+        shadowed[order[rank]] = contributions[order[rank]] > 0.0f;
+
+    const float step = started ? deltaTime / SHADOW_FADE_TIME : 1.0f;
+    started = true;
+    for (size_t i = 0; i < lights.size(); i++) {
+        const float fade = lights[i]->getShadowFade();
+        lights[i]->setShadowFade(shadowed[i] ? std::min(fade + step, 1.0f) : std::max(fade - step, 0.0f));
+    }
+}
+
+bool ShadowAtlas::update(const Camera &camera, const std::vector<Light *> &lights, const float deltaTime) {
+    updateFades(camera, lights, deltaTime);
+
+    // Unshadowed lights, once faded out, need no tile
+    std::vector<int> sizes(lights.size());
+    std::vector<float> priorities(lights.size());
+    for (size_t i = 0; i < lights.size(); i++) {
+        sizes[i] = lights[i]->getShadowFade() > 0.0f ? getRequestedSize(camera, *lights[i]) : 0;
+        priorities[i] = static_cast<float>(sizes[i]) * lights[i]->getShadowImportance();
+    }
+
+    // Halve the largest tile of the lowest priority until everything fits
+    auto area = [&sizes] {
+        return std::accumulate(sizes.begin(), sizes.end(), 0LL,
+                               [](const long long sum, const int size) { return sum + 1LL * size * size; });
+    };
+    while (area() > 1LL * SHADOW_ATLAS_SIZE * SHADOW_ATLAS_SIZE) {
+        int shrink = -1;
+        for (int i = 0; i < sizes.size(); i++) {
+            if (sizes[i] == 0)
+                continue;
+            if (shrink < 0 || sizes[i] > sizes[shrink] ||
+                (sizes[i] == sizes[shrink] && priorities[i] <= priorities[shrink]))
+                shrink = i;
+        }
+        // Lights past what even minimum tiles can hold cast no shadow
+        sizes[shrink] = sizes[shrink] > SHADOW_TILE_MIN ? sizes[shrink] / 2 : 0;
+    }
+
+    if (sizes == tileSizes)
+        return false;
+    tileSizes = sizes;
+
+    // Decreasing sizes, so the quadtree packs without holes
+    std::vector<int> order(lights.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sizes](const int a, const int b) { return sizes[a] > sizes[b]; });
+
+    allocator.reset();
+    tiles.assign(lights.size(), glm::ivec4(0));
+    for (const int i: order) {
+        if (sizes[i] > 0) {
+            const glm::ivec2 corner = allocator.allocate(sizes[i]);
+            tiles[i] = glm::ivec4(corner, sizes[i], sizes[i]);
+        }
+        lights[i]->setShadowRect(glm::vec4(tiles[i]) / static_cast<float>(SHADOW_ATLAS_SIZE));
+    }
+    return true;
+}
+
+void ShadowAtlas::setMaxShadowedLights(const int lights) {
+    maxShadowedLights = std::max(lights, 0);
+}
+
+int ShadowAtlas::getMaxShadowedLights() const {
+    return maxShadowedLights;
+}
+
+glm::ivec4 ShadowAtlas::getTile(const int light) const {
+    return light < tiles.size() ? tiles[light] : glm::ivec4(0);
+}
+
+glm::ivec4 ShadowAtlas::getQuadrant(const glm::ivec4 &tile, const int i) {
+    const int half = tile.z / 2;
+    return glm::ivec4(tile.x + i % 2 * half, tile.y + i / 2 * half, half, half);
+}
+
+glm::ivec4 ShadowAtlas::getHalf(const glm::ivec4 &tile, const int i) {
+    const int half = tile.z / 2;
+    return glm::ivec4(tile.x + i * half, tile.y, half, tile.w);
+}
+
+GLuint ShadowAtlas::getTexture() const {
+    return texture;
+}
+
+GLuint ShadowAtlas::getStaticTexture() const {
+    return staticTexture;
+}
+
+void ShadowAtlas::cleanup() {
+    if (texture != 0) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+    if (staticTexture != 0) {
+        glDeleteTextures(1, &staticTexture);
+        staticTexture = 0;
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef SHADOWATLAS_H
+#define SHADOWATLAS_H
+#include <vector>
+#include <glm/glm.hpp>
+#include "glad/gl.h"
+#include "view_points/camera/camera.h"
+#include "view_points/lights/light/Light.h"
+
+// One depth texture shared by every shadow casting light, in square power of two tiles
+#define SHADOW_ATLAS_SIZE 4096
+#define SHADOW_TILE_MAX 2048
+#define SHADOW_TILE_MIN 128
+
+// Lights with a shadow map at once, the others light unshadowed
+#define SHADOW_MAX_LIGHTS 8
+// Seconds a shadow takes to fade in or out as its light enters or leaves the shadowed lights
+#define SHADOW_FADE_TIME 0.5f
+
+// Square tiles of a square power of two area. Allocating in decreasing size order never fails while the total
+// area fits, since every free node then has at least the size of the next request.
+class QuadtreeAllocator {
+    struct Node {
+        int x, y, size;
+        int firstChild = -1;
+        bool used = false;
+    };
+
+    std::vector<Node> nodes;
+
+    int allocate(int node, int size);
+
+public:
+    explicit QuadtreeAllocator(int size);
+
+    void reset();
+
+    // Returns the corner of the tile, or (-1, -1) when no free node is large enough
+    glm::ivec2 allocate(int size);
+};
+
+// Places the shadow maps of the lights in a single atlas. Each frame the shadow casting lights are ranked by their
+// estimated contribution to the screen and only the first SHADOW_MAX_LIGHTS are shadowed, their shadows fading in
+// and out over SHADOW_FADE_TIME as the ranking changes. Each shadowed light, or light still fading out, gets a tile
+// sized by the share of the screen its range covers, scaled by its shadow importance, and tiles are shrunk, lowest
+// priority first, until they fit. The layout is only rebuilt when a size changes. Lights read their tile back
+// through Light::getShadowRect() and their fade through Light::getShadowFade().
+class ShadowAtlas {
+    GLuint texture = 0;
+    // Same layout, holding only the static casters of each tile
+    GLuint staticTexture = 0;
+    QuadtreeAllocator allocator;
+
+    std::vector<int> tileSizes;
+    std::vector<glm::ivec4> tiles;
+
+    int maxShadowedLights = SHADOW_MAX_LIGHTS;
+    // The first update shadows its lights at once
+    bool started = false;
+
+    // Height of the light's range sphere on screen, relative to the screen height
+    static float getCoverage(const Camera &camera, const Light &light);
+
+    static int getRequestedSize(const Camera &camera, const Light &light);
+
+    // Screen area covered, times the light's luminance and irradiance at the camera, times its shadow importance
+    static float getContribution(const Camera &camera, const Light &light);
+
+    // Moves the fade of every light towards 1 for the top ranked lights, 0 for the others
+    void updateFades(const Camera &camera, const std::vector<Light *> &lights, float deltaTime);
+
+public:
+    ShadowAtlas();
+
+    void setup();
+
+    // Ranks the lights, then sizes and places this frame's tiles. Returns true when the layout changed.
+    bool update(const Camera &camera, const std::vector<Light *> &lights, float deltaTime);
+
+    void setMaxShadowedLights(int lights);
+
+    [[nodiscard]] int getMaxShadowedLights() const;
+
+    // x, y, width and height in texels, a width of 0 if the light has no tile
+    [[nodiscard]] glm::ivec4 getTile(int light) const;
+
+    // Quadrant i of a tile, from the bottom left in rows, where directional lights keep their cascades
+    static glm::ivec4 getQuadrant(const glm::ivec4 &tile, int i);
+
+    // Left (0) or right (1) half of a tile, where point lights keep their paraboloid maps
+    static glm::ivec4 getHalf(const glm::ivec4 &tile, int i);
+
+    [[nodiscard]] GLuint getTexture() const;
+
+    [[nodiscard]] GLuint getStaticTexture() const;
+
+    void cleanup();
+};
+
+#endif //SHADOWATLAS_H
@@ -0,0 +1,19 @@
+#ifndef UNIFORMBLOCKS_H
+#define UNIFORMBLOCKS_H
+#include <map>
+#include <string>
+#include "glad/gl.h"
+
+// Binding points of the uniform blocks, the same in every program. GLSL 330 can not set them in the shader,
+// so ProgramUniforms assigns them when a program is reflected after linking.
+#define FRAME_BLOCK_BINDING 0
+#define VIEW_BLOCK_BINDING 1
+#define SHADOW_VIEWS_BLOCK_BINDING 2
+
+inline const std::map<std::string, GLuint> uniformBlockBindings = {
+    {"FrameUniforms", FRAME_BLOCK_BINDING},
+    {"ViewUniforms", VIEW_BLOCK_BINDING},
+    {"ShadowViews", SHADOW_VIEWS_BLOCK_BINDING},
+};
+
+#endif //UNIFORMBLOCKS_H
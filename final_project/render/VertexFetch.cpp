@@ -0,0 +1,68 @@
+#include "VertexFetch.h"
+
+#include <iostream>
+
+// Texture buffer over a copy of data, in the given texel format
+static void createTextureBuffer(GLuint &buffer, GLuint &texture, const void *data, const size_t size,
+                                const GLenum format) {
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(size), data, GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+bool VertexFetchBuffers::setup(const std::vector<glm::vec4> &vertices, const std::vector<GLuint> &indices) {
+    cleanup();
+    if (vertices.empty() || indices.empty())
+        return false;
+
+    // 65536 texels are all OpenGL 3.3 guarantees, drivers usually address far more
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    if (vertices.size() > static_cast<size_t>(maxTexels) || indices.size() > static_cast<size_t>(maxTexels)) {
+        std::cerr << "Vertex fetch buffers of " << vertices.size() << " and " << indices.size()
+                  << " texels exceed the texture buffer size of " << maxTexels << std::endl;
+        return false;
+    }
+
+    createTextureBuffer(vertexBuffer, vertexTexture, vertices.data(), vertices.size() * sizeof(glm::vec4),
+                        GL_RGBA32F);
+    createTextureBuffer(indexBuffer, indexTexture, indices.data(), indices.size() * sizeof(GLuint), GL_R32UI);
+    return true;
+}
+
+bool VertexFetchBuffers::isReady() const {
+    return vertexTexture != 0;
+}
+
+void VertexFetchBuffers::bind() const {
+    glActiveTexture(GL_TEXTURE0 + VERTEX_FETCH_VERTICES_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, vertexTexture);
+    glActiveTexture(GL_TEXTURE0 + VERTEX_FETCH_INDICES_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void VertexFetchBuffers::cleanup() {
+    if (vertexTexture != 0) {
+        glDeleteTextures(1, &vertexTexture);
+        vertexTexture = 0;
+    }
+    if (vertexBuffer != 0) {
+        glDeleteBuffers(1, &vertexBuffer);
+        vertexBuffer = 0;
+    }
+    if (indexTexture != 0) {
+        glDeleteTextures(1, &indexTexture);
+        indexTexture = 0;
+    }
+    if (indexBuffer != 0) {
+        glDeleteBuffers(1, &indexBuffer);
+        indexBuffer = 0;
+    }
+}
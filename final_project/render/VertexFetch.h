@@ -0,0 +1,36 @@
+#ifndef VERTEXFETCH_H
+#define VERTEXFETCH_H
+#include <vector>
+#include <glm/glm.hpp>
+#include "glad/gl.h"
+
+// Texture units of the fetchVertices and fetchIndices samplerBuffers in the visibility resolve
+#define VERTEX_FETCH_VERTICES_TEXTURE_UNIT 20
+#define VERTEX_FETCH_INDICES_TEXTURE_UNIT 21
+
+// RGBA32F texels per vertex, mirrored in shaders/common/vertex_fetch.glsl:
+//  (position, u), (normal, v), color, joints, weights
+#define VERTEX_FETCH_TEXELS 5
+
+// Every vertex of an object's draws in one texture buffer, and their triangles, strips and fans unrolled into
+// lists, in another, so that a shader can fetch the corners of any triangle it is given the index of. Vertex
+// attributes are expanded to floats whatever their glTF component type.
+class VertexFetchBuffers {
+    GLuint vertexBuffer = 0;
+    GLuint vertexTexture = 0;
+    GLuint indexBuffer = 0;
+    GLuint indexTexture = 0;
+
+public:
+    // VERTEX_FETCH_TEXELS texels per vertex. False, leaving the buffers empty, when they exceed what a texture
+    // buffer can address.
+    bool setup(const std::vector<glm::vec4> &vertices, const std::vector<GLuint> &indices);
+
+    [[nodiscard]] bool isReady() const;
+
+    void bind() const;
+
+    void cleanup();
+};
+
+#endif //VERTEXFETCH_H
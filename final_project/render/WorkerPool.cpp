@@ -0,0 +1,73 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(const int threadCount) {
+    for (int i = 1; i < threadCount; i++)
+        workers.emplace_back(&WorkerPool::work, this);
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker: workers)
+        worker.join();
+}
+
+WorkerPool &WorkerPool::shared() {
+    static WorkerPool pool(std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1,
+                                      WORKER_POOL_MAX_THREADS));
+    return pool;
+}
+
+int WorkerPool::getThreadCount() const {
+    return static_cast<int>(workers.size()) + 1;
+}
+
+void WorkerPool::runJobs(std::unique_lock<std::mutex> &lock) {
+    while (nextJob < jobCount) {
+        const int job = nextJob++;
+        const std::function<void(int)> &current = *task;
+        lock.unlock();
+        current(job);
+        lock.lock();
+        if (--unfinishedJobs == 0)
+            done.notify_all();
+    }
+}
+
+void WorkerPool::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || nextJob < jobCount; });
+        if (stopping)
+            return;
+        runJobs(lock);
+    }
+}
+
+void WorkerPool::run(const int count, const std::function<void(int)> &task) {
+    if (count <= 0)
+        return;
+    if (workers.empty() || count == 1) {
+        for (int i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    this->task = &task;
+    jobCount = count;
+    nextJob = 0;
+    unfinishedJobs = count;
+    wake.notify_all();
+
+    runJobs(lock);
+    done.wait(lock, [this] { return unfinishedJobs == 0; });
+    this->task = nullptr;
+    jobCount = 0;
+    nextJob = 0;
+}
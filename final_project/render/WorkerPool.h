@@ -0,0 +1,53 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Most threads the shared pool runs work on, the calling thread included
+#define WORKER_POOL_MAX_THREADS 8
+
+// Threads started once and kept waiting for work, so the per-frame CPU jobs (light clustering, per-view culling)
+// do not pay for creating and joining threads every frame. The calling thread works on the jobs too.
+class WorkerPool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    // Job of the current run(), valid until every index was handed out and finished
+    const std::function<void(int)> *task = nullptr;
+    int jobCount = 0;
+    int nextJob = 0;
+    int unfinishedJobs = 0;
+    bool stopping = false;
+
+    void work();
+
+    // Runs jobs until none is left to hand out, with the lock held between them
+    void runJobs(std::unique_lock<std::mutex> &lock);
+
+public:
+    // Starts threadCount - 1 workers
+    explicit WorkerPool(int threadCount);
+
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    // Pool of the hardware threads, up to WORKER_POOL_MAX_THREADS, started on first use
+    static WorkerPool &shared();
+
+    // Threads working on a run, the calling thread included
+    [[nodiscard]] int getThreadCount() const;
+
+    // Calls task(i) for every i in [0, count) across the threads, returns once all of them returned. Jobs must not
+    // call run() themselves.
+    void run(int count, const std::function<void(int)> &task);
+};
+
+#endif //WORKERPOOL_H
@@ -1,11 +1,73 @@
 #include "shader.h"
+#include "ProgramUniforms.h"
 
+#include <algorithm>
+#include <filesystem>
 #include <string> 
 #include <iostream> 
 #include <fstream>
 #include <sstream> 
 #include <vector>
 
+// Reads a shader and replaces its #include "file" lines, relative to the including file, by their contents. A file
+// already included in this shader is skipped, so common headers can include what they need. Each file is a source
+// string number of its own in #line directives, its index in files, so compile errors point at the right line.
+static bool ReadShaderFile(const std::string &file_path, std::string &code, std::vector<std::string> &files,
+						   const int depth = 0)
+{
+	std::ifstream stream(file_path, std::ios::in);
+	if (!stream.is_open() || depth > 8)
+		return false;
+
+	const int source = static_cast<int>(files.size());
+	files.push_back(std::filesystem::weakly_canonical(file_path).string());
+	if (source > 0)
+		code += "#line 1 " + std::to_string(source) + "\n";
+
+	const std::string directory = file_path.substr(0, file_path.find_last_of("/\\") + 1);
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(stream, line))
+	{
+		lineNumber++;
+		const size_t directive = line.find_first_not_of(" \t");
+		if (directive != std::string::npos && line.compare(directive, 8, "#include") == 0)
+		{
+			const size_t begin = line.find('"', directive);
+			const size_t end = line.find('"', begin + 1);
+			if (begin == std::string::npos || end == std::string::npos)
+			{
+				printf("Can not include %s in %s\n", line.c_str(), file_path.c_str());
+				return false;
+			}
+			const std::string included = directory + line.substr(begin + 1, end - begin - 1);
+			if (std::find(files.begin(), files.end(), std::filesystem::weakly_canonical(included).string()) !=
+				files.end())
+			{
+				code += '\n';
+				continue;
+			}
+			if (!ReadShaderFile(included, code, files, depth + 1))
+			{
+				printf("Can not include %s in %s\n", line.c_str(), file_path.c_str());
+				return false;
+			}
+			code += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(source) + "\n";
+			continue;
+		}
+		code += line;
+		code += '\n';
+	}
+	return true;
+}
+
+// Source string numbers of the compile log, as ReadShaderFile numbered them
+static void PrintShaderFiles(const std::vector<std::string> &files)
+{
+	for (size_t i = 0; i < files.size(); i++)
+		printf("  %zu: %s\n", i, files[i].c_str());
+}
+
 GLuint LoadShadersFromFile(const char *vertex_file_path, const char *fragment_file_path)
 {
 	// Create the shaders
@@ -14,15 +76,8 @@ GLuint LoadShadersFromFile(const char *vertex_file_path, const char *fragment_fi
 
 	// Read the Vertex Shader code from the file
 	std::string VertexShaderCode;
-	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-	if (VertexShaderStream.is_open())
-	{
-		std::stringstream sstr;
-		sstr << VertexShaderStream.rdbuf();
-		VertexShaderCode = sstr.str();
-		VertexShaderStream.close();
-	}
-	else
+	std::vector<std::string> VertexShaderFiles;
+	if (!ReadShaderFile(vertex_file_path, VertexShaderCode, VertexShaderFiles))
 	{
 		printf("Vertex shader not found %s.\n", vertex_file_path);
 		return 0;
@@ -30,15 +85,8 @@ GLuint LoadShadersFromFile(const char *vertex_file_path, const char *fragment_fi
 
 	// Read the Fragment Shader code from the file
 	std::string FragmentShaderCode;
-	std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-	if (FragmentShaderStream.is_open())
-	{
-		std::stringstream sstr;
-		sstr << FragmentShaderStream.rdbuf();
-		FragmentShaderCode = sstr.str();
-		FragmentShaderStream.close();
-	}
-	else
+	std::vector<std::string> FragmentShaderFiles;
+	if (!ReadShaderFile(fragment_file_path, FragmentShaderCode, FragmentShaderFiles))
 	{
 		printf("Fragment shader not found %s.\n", fragment_file_path);
 		return 0;
@@ -57,6 +105,7 @@ GLuint LoadShadersFromFile(const char *vertex_file_path, const char *fragment_fi
 	glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &Result);
 	if (!Result) {
 		printf("Error compiling vertex shader : %s\n", vertex_file_path);
+		PrintShaderFiles(VertexShaderFiles);
 		glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
 		if (InfoLogLength > 0) {
 			std::vector<char> VertexShaderErrorMessage(InfoLogLength + 1);
@@ -76,6 +125,7 @@ GLuint LoadShadersFromFile(const char *vertex_file_path, const char *fragment_fi
 	glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &Result);
 	if (!Result) {
 		printf("Error compiling fragment shader : %s\n", fragment_file_path);
+		PrintShaderFiles(FragmentShaderFiles);
 		glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
 		if (InfoLogLength > 0)
 		{
@@ -113,6 +163,8 @@ GLuint LoadShadersFromFile(const char *vertex_file_path, const char *fragment_fi
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
+	ProgramUniforms::reflect(ProgramID);
+
 	return ProgramID;
 }
 
@@ -190,5 +242,7 @@ GLuint LoadShadersFromString(const std::string &VertexShaderCode, const std::str
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
+	ProgramUniforms::reflect(ProgramID);
+
 	return ProgramID;
 }
@@ -0,0 +1,14 @@
+// Lights assigned to the clusters of the camera frustum by LightClusters (render/LightClusters.h).
+// Screen tiles of clusterGrid.w pixels times exponential depth slices, one (offset, count) pair per cluster
+// in clusterOffsets pointing into the light indices of clusterLights.
+uniform isamplerBuffer clusterOffsets;
+uniform isamplerBuffer clusterLights;
+uniform ivec4 clusterGrid;     // tiles x, tiles y, depth slices, tile size in pixels
+uniform vec2 clusterSlicing;   // slice = log(view depth) * x + y
+
+// Offset and count of the lights of the cluster containing a fragment
+ivec2 fetchCluster(vec2 fragCoord, float viewDepth) {
+    ivec2 tile = min(ivec2(fragCoord) / clusterGrid.w, clusterGrid.xy - 1);
+    int slice = clamp(int(log(max(viewDepth, 1e-4)) * clusterSlicing.x + clusterSlicing.y), 0, clusterGrid.z - 1);
+    return texelFetch(clusterOffsets, (slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x).xy;
+}
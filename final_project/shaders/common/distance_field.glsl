@@ -0,0 +1,43 @@
+// Cone traced shadows of the static casters, through the distance field baked by ShadowDistanceField
+// (passes/depth_pass/ShadowDistanceField.h). Needs common/uniform_blocks.glsl.
+#define DISTANCE_FIELD_STEPS 64
+// Unsigned distances, in voxels, below which the ray hits a caster. Trilinear filtering rounds the field off
+// to about half a voxel at the surface, a little more catches the surfaces the ray crosses between two steps.
+#define DISTANCE_FIELD_HIT 0.75
+// How far, in voxels, the ray starts off the receiver's surface along its normal. The field is baked from the
+// shadow proxies, which stray from the rendered surface by up to SHADOW_PROXY_MAX_ERROR of a part's size.
+#define DISTANCE_FIELD_OFFSET 2.5
+
+uniform sampler3D staticDistanceField;
+
+float staticDistance(vec3 worldPosition) {
+    vec3 UVW = (worldPosition - distanceFieldMin.xyz) / (distanceFieldMax.xyz - distanceFieldMin.xyz);
+    return texture(staticDistanceField, UVW).r;
+}
+
+// Visibility, from 0 to 1, of a light in a direction from a receiver with this world space normal, up to
+// maxDistance away. The nearest miss along the ray, against the cone widening by distanceField.z per unit,
+// gives the penumbra.
+float distanceFieldShadow(vec3 origin, vec3 normal, vec3 direction, float maxDistance) {
+    float voxel = distanceField.y;
+    float softness = distanceField.z;
+    origin += normal * DISTANCE_FIELD_OFFSET * voxel;
+
+    // Only the part of the ray inside the field can meet a static caster
+    vec3 inverseDirection = 1.0 / direction;
+    vec3 t0 = (distanceFieldMin.xyz - origin) * inverseDirection;
+    vec3 t1 = (distanceFieldMax.xyz - origin) * inverseDirection;
+    vec3 entries = min(t0, t1), exits = max(t0, t1);
+    float t = max(max(entries.x, entries.y), max(entries.z, 0.0));
+    float exit = min(min(exits.x, exits.y), min(exits.z, maxDistance));
+
+    float visibility = 1.0;
+    for (int s = 0; s < DISTANCE_FIELD_STEPS && t < exit; s++) {
+        float distance = staticDistance(origin + direction * t) - DISTANCE_FIELD_HIT * voxel;
+        if (distance <= 0.0)
+            return 0.0;
+        visibility = min(visibility, distance / (softness * max(t, voxel)));
+        t += max(distance, 0.25 * voxel);
+    }
+    return smoothstep(0.0, 1.0, visibility);
+}
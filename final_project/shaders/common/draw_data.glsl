@@ -0,0 +1,45 @@
+// Per-draw constants written once per frame by DrawDataRing (render/DrawDataRing.h), one RGBA32F texel per vec4.
+// drawID is the texel of the draw record of the current draw.
+uniform samplerBuffer drawData;
+uniform int drawID;
+
+struct DrawRecord {
+    mat4 model;
+    mat3 normalMatrix;              // Inverse transpose of the model matrix, written once per object on the CPU
+    int firstJoint;                 // -1 if the object is not skinned
+    int material;                   // Index in the material table of the object, -1 if it has none
+    int firstIndex;                 // First index of its triangles in common/vertex_fetch.glsl, -1 if not packed
+};
+
+mat4 fetchMatrix(int texel) {
+    return mat4(texelFetch(drawData, texel), texelFetch(drawData, texel + 1),
+                texelFetch(drawData, texel + 2), texelFetch(drawData, texel + 3));
+}
+
+DrawRecord fetchDrawRecordAt(int id) {
+    DrawRecord draw;
+    vec4 record = texelFetch(drawData, id);
+    int object = int(record.x);
+
+    draw.model = fetchMatrix(object);
+    draw.firstJoint = int(texelFetch(drawData, object + 4).x);
+    draw.normalMatrix = mat3(texelFetch(drawData, object + 5).xyz, texelFetch(drawData, object + 6).xyz,
+                             texelFetch(drawData, object + 7).xyz);
+    draw.material = int(record.y);
+    draw.firstIndex = int(record.z);
+    return draw;
+}
+
+DrawRecord fetchDrawRecord() {
+    return fetchDrawRecordAt(drawID);
+}
+
+mat4 skinMatrix(DrawRecord draw, vec4 joints, vec4 weights) {
+    if (draw.firstJoint < 0)
+        return mat4(1.0);
+
+    return weights.x * fetchMatrix(draw.firstJoint + 4 * int(joints.x)) +
+           weights.y * fetchMatrix(draw.firstJoint + 4 * int(joints.y)) +
+           weights.z * fetchMatrix(draw.firstJoint + 4 * int(joints.z)) +
+           weights.w * fetchMatrix(draw.firstJoint + 4 * int(joints.w));
+}
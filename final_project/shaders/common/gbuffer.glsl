@@ -0,0 +1,52 @@
+// Reads the G-buffer of GeometryPass (passes/geometry_pass/GeometryPass.h), positions are reconstructed from the
+// depth. Needs common/uniform_blocks.glsl.
+#include "octahedral.glsl"
+
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedo;
+
+// View space position of a depth buffer value at a screen position from 0 to 1
+vec3 viewPositionFromDepth(vec2 uv, float depth) {
+    vec4 position = inverseProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+vec3 gBufferViewPosition(vec2 uv) {
+    return viewPositionFromDepth(uv, texture(gDepth, uv).r);
+}
+
+vec3 gBufferViewPositionAt(ivec2 pixel) {
+    return viewPositionFromDepth((vec2(pixel) + 0.5) / vec2(textureSize(gDepth, 0)), texelFetch(gDepth, pixel, 0).r);
+}
+
+// Distance along the view axis, from the depth alone
+float gBufferViewDepth(vec2 uv) {
+    return projection[3][2] / (texture(gDepth, uv).r * 2.0 - 1.0 + projection[2][2]);
+}
+
+float gBufferViewDepthAt(ivec2 pixel) {
+    return projection[3][2] / (texelFetch(gDepth, pixel, 0).r * 2.0 - 1.0 + projection[2][2]);
+}
+
+vec3 gBufferWorldPosition(vec3 viewPosition) {
+    return (inverseView * vec4(viewPosition, 1.0)).xyz;
+}
+
+vec3 gBufferNormal(vec2 uv) {
+    return octahedralDecode(texture(gNormal, uv).rg);
+}
+
+vec3 gBufferNormalAt(ivec2 pixel) {
+    return octahedralDecode(texelFetch(gNormal, pixel, 0).rg);
+}
+
+// Pixels the lighting leaves as they are have the material ID 0, the stencil holds the same flag for the passes
+// that can test it
+bool gBufferUnlit(vec2 uv) {
+    return texture(gAlbedo, uv).a == 0.0;
+}
+
+bool gBufferUnlitAt(ivec2 pixel) {
+    return texelFetch(gAlbedo, pixel, 0).a == 0.0;
+}
@@ -0,0 +1,60 @@
+// Lights of the scene, uploaded by LightBuffer (render/LightBuffer.h) when they change.
+// Each light is a lightStruct (view_points/lights/light/Light.h) copied as is: 10 RGBA32F texels.
+uniform samplerBuffer lightData;
+
+#define POINT_LIGHT 0
+#define SPOT_LIGHT 1
+#define DIRECTIONAL_LIGHT 2
+#define LIGHT_TEXELS 10
+
+struct structLight {
+    vec3 position;
+    float intensity;
+
+    vec3 color;
+    // Weight of the shadow map, 0 for an unshadowed light
+    float shadowFade;
+
+    mat4 spaceMatrix;
+
+    int type;
+    float innerConeAngle;
+    float outerConeAngle;
+    // Depth range of a point light's paraboloid shadow maps, or of a spotlight's frustum
+    float shadowNear;
+
+    vec3 direction;
+    float shadowFar;
+
+    // Offset and size of the light's shadow map tile in the atlas, in UV
+    vec4 shadowRect;
+
+    // Channel of the shadow mask holding the light's visibility, -1 when its shadow map is sampled instead
+    int shadowMaskSlot;
+};
+
+structLight fetchLight(int i) {
+    int texel = i * LIGHT_TEXELS;
+    vec4 positionIntensity = texelFetch(lightData, texel);
+    vec4 typeCone = texelFetch(lightData, texel + 6);
+
+    structLight light;
+    light.position = positionIntensity.xyz;
+    light.intensity = positionIntensity.w;
+    vec4 colorFade = texelFetch(lightData, texel + 1);
+    light.color = colorFade.xyz;
+    light.shadowFade = colorFade.w;
+    light.spaceMatrix = mat4(texelFetch(lightData, texel + 2), texelFetch(lightData, texel + 3),
+                             texelFetch(lightData, texel + 4), texelFetch(lightData, texel + 5));
+    // Integers are stored as floats in lightStruct
+    light.type = int(typeCone.x);
+    light.innerConeAngle = typeCone.y;
+    light.outerConeAngle = typeCone.z;
+    light.shadowNear = typeCone.w;
+    vec4 directionFar = texelFetch(lightData, texel + 7);
+    light.direction = directionFar.xyz;
+    light.shadowFar = directionFar.w;
+    light.shadowRect = texelFetch(lightData, texel + 8);
+    light.shadowMaskSlot = int(texelFetch(lightData, texel + 9).x);
+    return light;
+}
@@ -0,0 +1,33 @@
+// Material table of the object being drawn, uploaded once at load time by GltfObject::uploadMaterialData.
+// MATERIAL_TEXELS RGBA32F texels per material, mirrors 3D_objects/gltf_object/GltfObject.h.
+#define MATERIAL_TEXELS 2
+
+uniform samplerBuffer materials;
+
+struct Material {
+    vec4 baseColorFactor;
+    int colorLayer;                 // Layer in the base color texture array, -1 if untextured
+    int metallicRoughnessLayer;     // Layer in the metallic roughness texture array, -1 if untextured
+};
+
+Material fetchMaterial(int material) {
+    Material m;
+    if (material < 0) {
+        m.baseColorFactor = vec4(1.0);
+        m.colorLayer = -1;
+        m.metallicRoughnessLayer = -1;
+        return m;
+    }
+
+    int texel = MATERIAL_TEXELS * material;
+    vec4 layers = texelFetch(materials, texel + 1);
+    m.baseColorFactor = texelFetch(materials, texel);
+    m.colorLayer = int(layers.x);
+    m.metallicRoughnessLayer = int(layers.y);
+    return m;
+}
+
+// ID of a material in the G-buffer, from 1 to 255, 0 is left for the unlit pixels
+int gBufferMaterialID(int material) {
+    return (material + 1) % 255 + 1;
+}
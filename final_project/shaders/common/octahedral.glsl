@@ -0,0 +1,17 @@
+// Unit vectors folded onto the octahedron |x| + |y| + |z| = 1, then unfolded into the unit square, as stored in
+// two channels such as the normals of the G-buffer.
+
+vec2 octahedralEncode(vec3 v) {
+    v /= abs(v.x) + abs(v.y) + abs(v.z);
+    // The lower half folds over the diagonals onto the corners of the square
+    vec2 folded = v.z >= 0.0 ? v.xy : (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    return folded * 0.5 + 0.5;
+}
+
+vec3 octahedralDecode(vec2 encoded) {
+    encoded = encoded * 2.0 - 1.0;
+    vec3 v = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-v.z, 0.0);
+    v.xy -= vec2(v.x >= 0.0 ? fold : -fold, v.y >= 0.0 ? fold : -fold);
+    return normalize(v);
+}
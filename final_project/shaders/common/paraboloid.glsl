@@ -0,0 +1,11 @@
+// Dual-paraboloid shadow maps of point lights (view_points/lights/light/Light.h). Each hemisphere is seen from the
+// light looking down -z and flattened onto the disc of radius 1, the distance to the light as linear depth. The back
+// hemisphere is the front one turned around the y axis.
+
+// Clip space position of a point in front of the hemisphere, depthRange holding the light's near and far distances
+vec4 projectParaboloid(vec3 viewPosition, vec2 depthRange) {
+    float distance = length(viewPosition);
+    vec3 direction = viewPosition / max(distance, 1e-6);
+    float depth = (distance - depthRange.x) / (depthRange.y - depthRange.x);
+    return vec4(direction.xy / (1.0 - direction.z), depth * 2.0 - 1.0, 1.0);
+}
@@ -0,0 +1,47 @@
+// Weighted reservoir sampling of lights for the stochastic lighting strategy (passes/lighting_pass/StochasticLighting.h).
+// A reservoir is stored in one RGBA32F texel: (light or -1, sum of the weights, sample count M, contribution weight W).
+// Needs common/lights.glsl and common/shading.glsl.
+uniform int lightCount;
+uniform int frameIndex;
+
+// PCG hash, one state per pixel and frame
+uint initRandom(vec2 fragCoord, int salt) {
+    return uint(fragCoord.x) * 1973u + uint(fragCoord.y) * 9277u + uint(frameIndex) * 26699u + uint(salt) * 104729u;
+}
+
+float random(inout uint state) {
+    state = state * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    word = (word >> 22u) ^ word;
+    return float(word) / 4294967296.0;
+}
+
+// Unshadowed luminance of a light, the function the light samples are distributed by
+float targetFunction(int i, vec3 worldPosition, vec3 normal, vec3 viewDir, vec3 diffuse, float ao) {
+    if (i < 0 || i >= lightCount)
+        return 0.0;
+    vec3 contribution = evaluateLight(fetchLight(i), i, worldPosition, normal, viewDir, diffuse, ao, false);
+    return max(dot(contribution, vec3(0.2126, 0.7152, 0.0722)), 0.0);
+}
+
+vec4 emptyReservoir() {
+    return vec4(-1.0, 0.0, 0.0, 0.0);
+}
+
+// Streams one candidate with its resampling weight into the reservoir
+void updateReservoir(inout vec4 reservoir, int light, float weight, inout uint state) {
+    reservoir.y += weight;
+    if (weight > 0.0 && random(state) * reservoir.y <= weight)
+        reservoir.x = float(light);
+}
+
+// Merges another reservoir, its sample being reweighted by the target function at this pixel
+void combineReservoir(inout vec4 reservoir, vec4 other, float targetAtPixel, inout uint state) {
+    updateReservoir(reservoir, int(other.x), targetAtPixel * other.w * other.z, state);
+    reservoir.z += other.z;
+}
+
+// Contribution weight of the selected sample, its 1 / pdf
+void finalizeReservoir(inout vec4 reservoir, float targetOfSample) {
+    reservoir.w = targetOfSample > 0.0 ? reservoir.y / (reservoir.z * targetOfSample) : 0.0;
+}
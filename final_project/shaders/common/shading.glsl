@@ -0,0 +1,172 @@
+// Phong shading of one light with its shadow map, shared by the lighting strategies of LightingPass.
+// Needs common/lights.glsl.
+#include "uniform_blocks.glsl"
+#include "gbuffer.glsl"
+#include "paraboloid.glsl"
+#include "shadow_moments.glsl"
+#include "shadow_mask.glsl"
+#include "distance_field.glsl"
+
+// Shadow maps of all the lights, each in the tile given by its shadowRect (render/ShadowAtlas.h)
+uniform sampler2D shadowAtlas;
+// Their blurred and mipmapped moments, same layout, read instead when shadowFilter.x is 1
+uniform sampler2D shadowMoments;
+
+float specularStrength = 0.3;
+float shininess = 15.0;
+
+// Depth test against a tile of the atlas, UVCoords.xy spanning the tile from 0 to 1. With filtered shadows,
+// UVCoords.z is the linear depth of the fragment.
+float sampleShadowAtlas(vec3 UVCoords, vec4 shadowRect) {
+    // No tile in the atlas, or outside of the light's frustum
+    if (shadowRect.z <= 0.0 || any(lessThan(UVCoords.xy, vec2(0.0))) || any(greaterThan(UVCoords.xy, vec2(1.0))))
+        return 1.0;
+
+    if (shadowFilter.x > 0.0) {
+        // Half a texel of the coarsest level read in, so the bilinear taps stay inside the tile
+        vec2 margin = 0.5 * exp2(ceil(shadowFilter.y)) / vec2(textureSize(shadowMoments, 0));
+        vec2 UV = clamp(shadowRect.xy + UVCoords.xy * shadowRect.zw, shadowRect.xy + margin,
+                        shadowRect.xy + shadowRect.zw - margin);
+        vec4 moments = textureLod(shadowMoments, UV, shadowFilter.y);
+        return mix(0.2, 1.0, momentsVisibility(moments, clamp(UVCoords.z, 0.0, 1.0)));
+    }
+
+    float existingDepth = texture(shadowAtlas, shadowRect.xy + UVCoords.xy * shadowRect.zw).x;
+    float currentDepth = UVCoords.z;
+    float bias = 1e-3;
+
+    return currentDepth >= existingDepth + bias ? 0.2 : 1.0;
+}
+
+// Shadow of a spotlight, depthRange holding its near and far planes
+float shadowCalculation(vec4 fragPosLightSpace, vec4 shadowRect, vec2 depthRange) {
+    if (fragPosLightSpace.z < 0)
+        return 1.0;
+
+    vec3 UVCoords = fragPosLightSpace.xyz / fragPosLightSpace.w * 0.5 + 0.5;
+    // The moments are of linear depths, w is the view depth
+    if (shadowFilter.x > 0.0)
+        UVCoords.z = (fragPosLightSpace.w - depthRange.x) / (depthRange.y - depthRange.x);
+    return sampleShadowAtlas(UVCoords, shadowRect);
+}
+
+// Shadow of a point light, from the paraboloid map of the hemisphere containing the fragment. The front hemisphere
+// is the left half of the light's tile, the back one the right half.
+float paraboloidShadowCalculation(vec3 worldPosition, structLight light) {
+    vec3 viewPosition = (light.spaceMatrix * vec4(worldPosition, 1.0)).xyz;
+    bool back = viewPosition.z > 0.0;
+    if (back)
+        viewPosition = vec3(-viewPosition.x, viewPosition.y, -viewPosition.z);
+
+    vec3 UVCoords = projectParaboloid(viewPosition, vec2(light.shadowNear, light.shadowFar)).xyz * 0.5 + 0.5;
+    vec4 hemisphere = vec4(light.shadowRect.xy + vec2(back ? 0.5 * light.shadowRect.z : 0.0, 0.0),
+                           0.5 * light.shadowRect.z, light.shadowRect.w);
+    return sampleShadowAtlas(UVCoords, hemisphere);
+}
+
+// Shadow of the directional light, from the first cascade containing the fragment. The cascades are the 2x2
+// quadrants of the light's tile.
+float cascadeShadowCalculation(vec3 worldPosition, vec4 shadowRect) {
+    float viewDepth = -(view * vec4(worldPosition, 1.0)).z;
+    for (int c = 0; c < CSM_CASCADES; c++) {
+        if (viewDepth <= cascadeSplits[c]) {
+            vec3 UVCoords = (cascadeMatrices[c] * vec4(worldPosition, 1.0)).xyz * 0.5 + 0.5;
+            vec2 quadrant = vec2(c % 2, c / 2) * 0.5;
+            return sampleShadowAtlas(UVCoords, vec4(shadowRect.xy + quadrant * shadowRect.zw, shadowRect.zw * 0.5));
+        }
+    }
+    return 1.0;
+}
+
+// Shadow of light i from its shadow map, 1 without a tile
+float shadowMapCalculation(structLight light, int i, vec3 worldPosition) {
+    if (light.type == DIRECTIONAL_LIGHT)
+        return i == cascadeLight.x ? cascadeShadowCalculation(worldPosition, light.shadowRect) : 1.0;
+    if (light.type == POINT_LIGHT)
+        return paraboloidShadowCalculation(worldPosition, light);
+    return shadowCalculation(light.spaceMatrix * vec4(worldPosition, 1.0), light.shadowRect,
+                             vec2(light.shadowNear, light.shadowFar));
+}
+
+// Shadow of light i, of a light with a fade. The static casters are in its shadow map, or in the distance field
+// when distanceField.x is 1, the darker of both wins. normal is in view space, as in the G-buffer.
+float lightShadow(structLight light, int i, vec3 worldPosition, vec3 normal) {
+    float shadow = shadowMapCalculation(light, i, worldPosition);
+    if (distanceField.x > 0.0) {
+        vec3 toLight = light.type == DIRECTIONAL_LIGHT ? -light.direction : light.position - worldPosition;
+        float maxDistance = light.type == DIRECTIONAL_LIGHT ? 1e30 : length(toLight);
+        float visibility = distanceFieldShadow(worldPosition, normalize(mat3(inverseView) * normal),
+                                               normalize(toLight), maxDistance);
+        shadow = min(shadow, mix(0.2, 1.0, visibility));
+    }
+    return shadow;
+}
+
+float calculateSpotLightEffect(structLight light, vec3 worldPos) {
+    // On calcule la direction entre la position de la lumière et le point éclairé
+    vec3 L = normalize(worldPos - light.position);
+
+    // On compare avec la direction du spot
+    float cosTheta = dot(L, normalize(light.direction));
+
+    // Conversion des angles en cosinus
+    float innerCos = cos(light.innerConeAngle);
+    float outerCos = cos(light.outerConeAngle);
+
+    // Calcul de l'atténuation du spot
+    float epsilon = innerCos - outerCos;
+    float intensity = clamp((cosTheta - outerCos) / epsilon, 0.0, 1.0);
+
+    return intensity;
+}
+
+// Contribution of light i at a G-buffer sample, without its shadow map lookup when shadowed is false
+vec3 evaluateLight(structLight light, int i, vec3 worldPosition, vec3 normal, vec3 viewDir, vec3 diffuse, float ao,
+                   bool shadowed) {
+    vec3 lightPosition = light.position;
+    float lightIntensity = light.intensity;
+    vec3 lightColor = light.color;
+
+    vec3 lightDir = lightPosition - worldPosition;
+    float distance = length(lightDir);
+    lightDir = normalize(lightDir);
+
+    // Infinitely far, without falloff
+    if (light.type == DIRECTIONAL_LIGHT) {
+        lightDir = -normalize(light.direction);
+        distance = 1.0;
+    }
+
+    // Lights left without a shadow map or a distance field skip the lookup, those in the shadow mask read it instead
+    float shadowFactor = 1.0;
+    shadowed = shadowed && light.shadowFade > 0.0 && (light.shadowRect.z > 0.0 || distanceField.x > 0.0);
+    if (shadowed && light.shadowMaskSlot >= 0)
+        shadowFactor = readShadowMask(light.shadowMaskSlot);
+    else if (shadowed)
+        shadowFactor = lightShadow(light, i, worldPosition, normal);
+    shadowFactor = mix(1.0, shadowFactor, light.shadowFade);
+
+    float NdotL = max(dot(normal, lightDir), 0.0);
+    vec3 diffuseLight = diffuse * NdotL * lightColor;
+
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
+    vec3 specularLight = specularStrength * spec * lightColor;
+
+    float attenuation = lightIntensity / (distance * distance);
+    float intensity = 1.0;
+
+    // Handle different light types
+    if (light.type == POINT_LIGHT) {
+        // Point light attenuation is already handled above
+        intensity = 1.0;
+    }
+    else if (light.type == SPOT_LIGHT) {
+        intensity = calculateSpotLightEffect(light, worldPosition);
+        if (intensity <= 0.0) return vec3(0.0);
+    }
+
+    vec3 lightContribution = shadowFactor * attenuation * intensity * (diffuseLight + specularLight);
+    lightContribution *= mix(1.0, ao, 2);
+    return lightContribution;
+}
@@ -0,0 +1,54 @@
+// Visibility of the shadowed lights, computed by ShadowMask (passes/lighting_pass/ShadowMask.h) at a lower
+// resolution than the screen, 4 lights per RGBA8 target. Needs common/gbuffer.glsl.
+#define SHADOW_MASK_LIGHTS 8
+// View depth difference, relative to the pixel's depth, past which a mask sample is on another surface
+#define SHADOW_MASK_DEPTH_TOLERANCE 0.02
+
+uniform sampler2D shadowMask0;
+uniform sampler2D shadowMask1;
+
+// Full resolution pixel a mask texel is computed at, the center of those it covers
+ivec2 shadowMaskSource(ivec2 maskTexel, int scale) {
+    return maskTexel * scale + scale / 2;
+}
+
+// The mask at this pixel, upsampled on first use
+vec4 shadowMaskValues[2];
+bool shadowMaskLoaded = false;
+
+// Bilinear upsample of the 4 nearest mask texels, those on another surface than the pixel barely count
+void loadShadowMask() {
+    ivec2 size = textureSize(gDepth, 0);
+    ivec2 maskSize = textureSize(shadowMask0, 0);
+    int scale = max(int(round(float(size.x) / float(maskSize.x))), 1);
+
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = max(gBufferViewDepthAt(pixel), 1e-3);
+    vec2 position = (vec2(pixel) + 0.5) / float(scale) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 fraction = position - vec2(base);
+
+    shadowMaskValues[0] = vec4(0.0);
+    shadowMaskValues[1] = vec4(0.0);
+    float totalWeight = 0.0;
+    for (int k = 0; k < 4; k++) {
+        ivec2 offset = ivec2(k % 2, k / 2);
+        ivec2 texel = clamp(base + offset, ivec2(0), maskSize - 1);
+        vec2 bilinear = mix(1.0 - fraction, fraction, vec2(offset));
+        float sampleDepth = gBufferViewDepthAt(min(shadowMaskSource(texel, scale), size - 1));
+        float difference = abs(sampleDepth - depth) / (SHADOW_MASK_DEPTH_TOLERANCE * depth);
+        float weight = bilinear.x * bilinear.y / (1.0 + difference * difference) + 1e-6;
+        shadowMaskValues[0] += weight * texelFetch(shadowMask0, texel, 0);
+        shadowMaskValues[1] += weight * texelFetch(shadowMask1, texel, 0);
+        totalWeight += weight;
+    }
+    shadowMaskValues[0] /= totalWeight;
+    shadowMaskValues[1] /= totalWeight;
+    shadowMaskLoaded = true;
+}
+
+float readShadowMask(int slot) {
+    if (!shadowMaskLoaded)
+        loadShadowMask();
+    return shadowMaskValues[slot / 4][slot % 4];
+}
@@ -0,0 +1,41 @@
+// Exponential variance shadow maps (passes/depth_pass/ShadowFilter.h). Linear depths in [0, 1] are warped by a
+// positive and a negative exponential, and the first two moments of both warps are blurred and mipmapped, so a
+// single filtered fetch gives the share of an area of the map in front of a depth.
+
+// Largest exponents whose squared warps a 16 bit float still holds
+#define EVSM_POSITIVE_EXPONENT 5.54
+#define EVSM_NEGATIVE_EXPONENT 5.54
+// Depth difference below which a receiver is not shadowed by the surface it lies on
+#define EVSM_DEPTH_EPSILON 0.0005
+// Low visibilities cut off, against the light leaking where occluders overlap
+#define EVSM_BLEEDING_REDUCTION 0.2
+
+vec2 warpDepth(float depth) {
+    depth = 2.0 * depth - 1.0;
+    return vec2(exp(EVSM_POSITIVE_EXPONENT * depth), -exp(-EVSM_NEGATIVE_EXPONENT * depth));
+}
+
+vec4 depthMoments(float depth) {
+    vec2 warped = warpDepth(depth);
+    return vec4(warped.x, warped.x * warped.x, warped.y, warped.y * warped.y);
+}
+
+// Upper bound of the share of the depths behind mean
+float chebyshevUpperBound(vec2 moments, float mean, float minVariance) {
+    if (mean <= moments.x)
+        return 1.0;
+    float variance = max(moments.y - moments.x * moments.x, minVariance);
+    float difference = mean - moments.x;
+    float visibility = variance / (variance + difference * difference);
+    return clamp((visibility - EVSM_BLEEDING_REDUCTION) / (1.0 - EVSM_BLEEDING_REDUCTION), 0.0, 1.0);
+}
+
+// Share of the light reaching a receiver at this linear depth
+float momentsVisibility(vec4 moments, float depth) {
+    vec2 warped = warpDepth(depth);
+    // EVSM_DEPTH_EPSILON through the slope of each warp
+    vec2 minVariance = 2.0 * EVSM_DEPTH_EPSILON * vec2(EVSM_POSITIVE_EXPONENT, EVSM_NEGATIVE_EXPONENT) * abs(warped);
+    minVariance *= minVariance;
+    return min(chebyshevUpperBound(moments.xy, warped.x, minVariance.x),
+               chebyshevUpperBound(moments.zw, warped.y, minVariance.y));
+}
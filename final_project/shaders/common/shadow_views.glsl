@@ -0,0 +1,19 @@
+// Shadow views of one instanced caster submission, filled by DepthPass (passes/depth_pass/DepthPass.h).
+// Instance i of a draw renders into view instanceViews[firstInstance + i], each view a tile of the shadow atlas.
+#define MAX_SHADOW_VIEWS 64
+#define MAX_SHADOW_INSTANCES 1024
+
+layout(std140) uniform ShadowViews {
+    mat4 viewProjections[MAX_SHADOW_VIEWS];
+    vec4 viewports[MAX_SHADOW_VIEWS];       // center and half size of the tile, in the atlas' device coordinates
+    vec4 projections[MAX_SHADOW_VIEWS];     // 1 and the light's depth range for paraboloid views, which hold the
+                                            // hemisphere's view matrix in viewProjections
+    ivec4 instanceViews[MAX_SHADOW_INSTANCES / 4];
+};
+
+uniform int firstInstance;
+
+int fetchShadowView() {
+    int instance = firstInstance + gl_InstanceID;
+    return instanceViews[instance / 4][instance % 4];
+}
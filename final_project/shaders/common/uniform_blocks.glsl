@@ -0,0 +1,31 @@
+// Blocks shared by every pass, filled once per frame by FrameUniforms (render/FrameUniforms.h).
+// Binding points are fixed in render/UniformBlocks.h.
+
+// Shadow cascades of the directional light (view_points/lights/directional_light/DirectionalLight.h)
+#define CSM_CASCADES 4
+
+// Camera and frame constants
+layout(std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 inverseView;
+    mat4 inverseProjection;
+    vec4 viewport;          // width, height, 1 / width, 1 / height
+    vec4 time;              // animation time, delta time
+    vec4 ssaoSamples[64];
+    mat4 cascadeMatrices[CSM_CASCADES];
+    vec4 cascadeSplits;     // far view depth of each cascade
+    ivec4 cascadeLight;     // index of the light the cascades belong to, -1 if none
+    vec4 shadowFilter;      // 1 when the shadows read the moments of the maps, mip level they read
+    vec4 distanceField;     // 1 when the static casters are traced in the distance field, voxel size, softness
+    vec4 distanceFieldMin;  // world space bounds of the distance field
+    vec4 distanceFieldMax;
+};
+
+// View currently rendered: the camera or one of the lights
+layout(std140) uniform ViewUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 position;
+} currentView;
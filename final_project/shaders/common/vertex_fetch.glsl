@@ -0,0 +1,36 @@
+// Vertices and triangles of the object being resolved, packed by VertexFetchBuffers (render/VertexFetch.h):
+// VERTEX_FETCH_TEXELS RGBA32F texels per vertex, and the triangles of every draw as lists of indices into them.
+#define VERTEX_FETCH_TEXELS 5
+
+uniform samplerBuffer fetchVertices;
+uniform usamplerBuffer fetchIndices;
+
+struct FetchedVertex {
+    vec3 position;
+    vec3 normal;
+    vec2 uv;
+    vec4 color;
+    vec4 joints;
+    vec4 weights;
+};
+
+FetchedVertex fetchVertex(int vertex) {
+    int texel = VERTEX_FETCH_TEXELS * vertex;
+    vec4 positionU = texelFetch(fetchVertices, texel);
+    vec4 normalV = texelFetch(fetchVertices, texel + 1);
+
+    FetchedVertex v;
+    v.position = positionU.xyz;
+    v.normal = normalV.xyz;
+    v.uv = vec2(positionU.w, normalV.w);
+    v.color = texelFetch(fetchVertices, texel + 2);
+    v.joints = texelFetch(fetchVertices, texel + 3);
+    v.weights = texelFetch(fetchVertices, texel + 4);
+    return v;
+}
+
+// Vertices of a triangle of the draw whose triangles start at firstIndex
+ivec3 fetchTriangle(int firstIndex, int triangle) {
+    int i = firstIndex + 3 * triangle;
+    return ivec3(texelFetch(fetchIndices, i).x, texelFetch(fetchIndices, i + 1).x, texelFetch(fetchIndices, i + 2).x);
+}
@@ -0,0 +1,4 @@
+// Visibility buffer of GeometryPass (passes/geometry_pass/GeometryPass.h): for each pixel, the draw ID of the draw
+// record and the gl_PrimitiveID of the triangle it sees, resolved into the G-buffer by visibility_resolve.frag.
+// Pixels the geometry pass shaded itself hold VISIBILITY_NONE.
+#define VISIBILITY_NONE 0xFFFFFFFFu
@@ -1,25 +1,33 @@
 #version 330 core
+#include "common/uniform_blocks.glsl"
+#include "common/draw_data.glsl"
+#include "common/paraboloid.glsl"
+
 layout(location = 0) in vec3 vertexPosition;
 layout(location = 1) in vec3 vertexNormal;
 layout(location = 2) in vec2 vertexUV;
 layout(location = 3) in vec4 a_joint;
 layout(location = 4) in vec4 a_weight;
 
-uniform mat4 mvp;
-uniform int animated;
-uniform mat4 jointMatrices[100];
+// Hemisphere of a point light rendered instead of the current view when paraboloid.x is 1, paraboloid.yz holding
+// the light's depth range
+uniform mat4 paraboloidView;
+uniform vec3 paraboloid;
+
+out float gl_ClipDistance[1];
 
 void main() {
-    mat4 finalMatrix;
-    if (animated == 1) {
-        mat4 skinMatrix =
-        a_weight.x * jointMatrices[int(a_joint.x)] +
-        a_weight.y * jointMatrices[int(a_joint.y)] +
-        a_weight.z * jointMatrices[int(a_joint.z)] +
-        a_weight.w * jointMatrices[int(a_joint.w)];
-        finalMatrix = skinMatrix;
-    } else {
-        finalMatrix = mat4(1.0);
+    DrawRecord draw = fetchDrawRecord();
+    mat4 finalMatrix = skinMatrix(draw, a_joint, a_weight);
+    vec4 worldPosition = draw.model * finalMatrix * vec4(vertexPosition, 1.0);
+
+    // The other hemisphere is clipped away
+    if (paraboloid.x > 0.0) {
+        vec3 viewPosition = (paraboloidView * worldPosition).xyz;
+        gl_ClipDistance[0] = -viewPosition.z;
+        gl_Position = projectParaboloid(viewPosition, paraboloid.yz);
+        return;
     }
-    gl_Position = mvp * finalMatrix * vec4(vertexPosition, 1.0);
+    gl_ClipDistance[0] = 1.0;
+    gl_Position = currentView.viewProjection * worldPosition;
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#version 330 core
+#include "common/draw_data.glsl"
+#include "common/shadow_views.glsl"
+#include "common/paraboloid.glsl"
+
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 1) in vec3 vertexNormal;
+layout(location = 2) in vec2 vertexUV;
+layout(location = 3) in vec4 a_joint;
+layout(location = 4) in vec4 a_weight;
+
+out float gl_ClipDistance[5];
+
+void main() {
+    DrawRecord draw = fetchDrawRecord();
+    mat4 finalMatrix = skinMatrix(draw, a_joint, a_weight);
+
+    int view = fetchShadowView();
+    vec4 position = viewProjections[view] * draw.model * finalMatrix * vec4(vertexPosition, 1.0);
+
+    // Hemisphere of a point light, the other one is clipped away
+    gl_ClipDistance[4] = 1.0;
+    if (projections[view].x > 0.0) {
+        gl_ClipDistance[4] = -position.z;
+        position = projectParaboloid(position.xyz, projections[view].yz);
+    }
+
+    // Clipped to the sides of the view's frustum, then moved into its tile
+    gl_ClipDistance[0] = position.w + position.x;
+    gl_ClipDistance[1] = position.w - position.x;
+    gl_ClipDistance[2] = position.w + position.y;
+    gl_ClipDistance[3] = position.w - position.y;
+    gl_Position = vec4(position.xy * viewports[view].zw + viewports[view].xy * position.w, position.zw);
+}
@@ -1,20 +1,21 @@
 #version 330 core
-layout (location = 0) out vec3 gPosition;
-layout (location = 1) out vec3 gNormal;
-layout (location = 2) out vec3 gAlbedo;
-layout (location = 3) out vec3 gPositionWorld;
-layout (location = 4) out float gIgnoreLightingPass;
+#include "common/octahedral.glsl"
+#include "common/visibility.glsl"
+
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedo;
+// Only drawn to in the visibility mode of GeometryPass, where it keeps this fragment out of the resolve
+layout (location = 2) out uvec2 visibility;
 
 in vec2 TexCoords;
-in vec3 FragPos;
-in vec3 FragPosWorld;
 in vec3 Normal;
 in vec4 color;
 flat in int texIndex;
 flat in int metTexIndex;
+flat in vec4 baseColorFactor;
+flat in int materialID;
 
 uniform int ignoreLightingPass;
-uniform vec4 baseColorFactor;
 uniform sampler2DArray textureArray;
 uniform sampler2DArray metTextureArray;
 uniform sampler2DArray depthArray;
@@ -22,16 +23,14 @@ uniform sampler2D textureSampler;
 
 void main()
 {
-    gPosition = FragPos;
-    gPositionWorld = FragPosWorld;
-
-    gNormal = normalize(Normal);
+    // Positions are reconstructed from the depth buffer
+    gNormal = octahedralEncode(normalize(Normal));
+    visibility = uvec2(VISIBILITY_NONE);
 
     vec4 baseColor = ((texIndex!=-1) ? texture(textureArray, vec3(TexCoords, texIndex)) : color);
     baseColor *= baseColorFactor;
-    gIgnoreLightingPass = ignoreLightingPass;
 
     if (ignoreLightingPass==1)
-    gAlbedo.rgb = (texture(textureSampler, TexCoords)).rgb;
-    else gAlbedo.rgb = baseColor.rgb;
+    gAlbedo = vec4((texture(textureSampler, TexCoords)).rgb, 0.0);
+    else gAlbedo = vec4(baseColor.rgb, float(materialID) / 255.0);
 }
\ No newline at end of file
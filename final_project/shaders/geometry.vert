@@ -1,4 +1,8 @@
 #version 330 core
+#include "common/uniform_blocks.glsl"
+#include "common/draw_data.glsl"
+#include "common/materials.glsl"
+
 layout(location = 0) in vec3 vertexPosition;
 layout(location = 1) in vec3 vertexNormal;
 layout(location = 2) in vec2 vertexUV;
@@ -6,41 +10,24 @@ layout(location = 3) in vec4 a_joint;
 layout(location = 4) in vec4 a_weight;
 layout(location = 5) in vec4 m_color;
 
-out vec3 FragPos;
-out vec3 FragPosWorld;
 out vec2 TexCoords;
 out vec3 Normal;
 out vec4 color;
 flat out int texIndex;
 flat out int metTexIndex;
+flat out vec4 baseColorFactor;
+flat out int materialID;
 
 uniform bool invertedNormals;
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform int colorTextureIndex;
-uniform int metTextureIndex;
-uniform int animated;
-
-uniform mat4 jointMatrices[100];
 
 void main()
 {
-    mat4 finalMatrix = mat4(1.0);
-
-    if (animated == 1) {
-        finalMatrix =
-        a_weight.x * jointMatrices[int(a_joint.x)] +
-        a_weight.y * jointMatrices[int(a_joint.y)] +
-        a_weight.z * jointMatrices[int(a_joint.z)] +
-        a_weight.w * jointMatrices[int(a_joint.w)];
-    }
+    DrawRecord draw = fetchDrawRecord();
+    mat4 model = draw.model;
+    mat4 finalMatrix = skinMatrix(draw, a_joint, a_weight);
 
     // Position en espace vue
     vec4 viewPos = view * model * finalMatrix * vec4(vertexPosition, 1.0);
-    FragPos = viewPos.xyz;
-    vec4 worldPosition = model * finalMatrix * vec4(vertexPosition, 1.0);
-    FragPosWorld = vec3(worldPosition);
 
     TexCoords = vertexUV;
 
@@ -50,7 +37,10 @@ void main()
 
     gl_Position = projection * viewPos;
 
-    texIndex = colorTextureIndex;
-    metTexIndex = metTextureIndex;
+    Material material = fetchMaterial(draw.material);
+    texIndex = material.colorLayer;
+    metTexIndex = material.metallicRoughnessLayer;
+    baseColorFactor = material.baseColorFactor;
+    materialID = gBufferMaterialID(draw.material);
     color = m_color;
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+#include "common/uniform_blocks.glsl"
+#include "common/gbuffer.glsl"
+
+uniform sampler2D ssao;
+
+uniform sampler2D radiance;
+
+#define DENOISE_RADIUS 2
+
+void main() {
+    vec4 albedo = texture(gAlbedo, TexCoords);
+    vec3 Diffuse = albedo.rgb;
+    if (albedo.a == 0.0) {
+        FragColor = vec4(Diffuse, 1.0);
+        return;
+    }
+
+    vec3 normal = gBufferNormal(TexCoords);
+    float depth = gBufferViewDepth(TexCoords);
+    vec2 texelSize = 1.0 / vec2(textureSize(radiance, 0));
+
+    // Cross bilateral filter guided by the G-buffer normals and depths
+    vec3 sum = vec3(0.0);
+    float weightSum = 0.0;
+    for (int x = -DENOISE_RADIUS; x <= DENOISE_RADIUS; x++) {
+        for (int y = -DENOISE_RADIUS; y <= DENOISE_RADIUS; y++) {
+            vec2 uv = TexCoords + vec2(x, y) * texelSize;
+            vec3 sampleNormal = gBufferNormal(uv);
+            float sampleDepth = gBufferViewDepth(uv);
+
+            float weight = exp(-float(x * x + y * y) / 4.5);
+            weight *= pow(max(dot(normal, sampleNormal), 0.0), 32.0);
+            weight *= exp(-abs(sampleDepth - depth) / (0.02 * depth + 1e-4));
+            weight *= gBufferUnlit(uv) ? 0.0 : 1.0;
+
+            sum += texture(radiance, uv).rgb * weight;
+            weightSum += weight;
+        }
+    }
+    vec3 phongLighting = (weightSum > 0.0 ? sum / weightSum : vec3(0.0)) * max(Diffuse, vec3(0.02));
+
+    float AmbientOcclusion = texture(ssao, TexCoords).r;
+    vec3 ambient = 0.05 * Diffuse * pow(AmbientOcclusion, 2);
+
+    vec3 lighting = ambient + phongLighting;
+
+    lighting = pow(lighting, vec3(1.0/2.2));// Gamma correction
+
+    FragColor = vec4(lighting, 1.0);
+}
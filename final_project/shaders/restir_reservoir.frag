@@ -0,0 +1,65 @@
+#version 330 core
+layout (location = 0) out vec4 reservoirOut;
+layout (location = 1) out vec4 positionOut;
+
+in vec2 TexCoords;
+
+uniform sampler2D ssao;
+
+uniform sampler2D previousReservoirs;
+uniform sampler2D previousPositions;
+uniform mat4 previousViewProjection;
+uniform int temporalReuse;
+
+#include "common/lights.glsl"
+#include "common/shading.glsl"
+#include "common/reservoir.glsl"
+
+// Light candidates drawn uniformly per pixel and frame
+#define CANDIDATES 8
+// History is capped so the reservoir still follows moving lights and objects
+#define TEMPORAL_MAX_M 20.0
+
+void main() {
+    if (gBufferUnlit(TexCoords) || lightCount == 0) {
+        reservoirOut = emptyReservoir();
+        positionOut = vec4(0.0);
+        return;
+    }
+
+    vec3 fragPos = gBufferViewPosition(TexCoords);
+    vec3 worldPosition = gBufferWorldPosition(fragPos);
+    vec3 normal = gBufferNormal(TexCoords);
+    vec3 diffuse = texture(gAlbedo, TexCoords).rgb;
+    float ao = texture(ssao, TexCoords).r;
+    vec3 viewDir = normalize(-fragPos);
+    uint state = initRandom(gl_FragCoord.xy, 0);
+
+    // Resampled importance sampling: candidates from a uniform pdf, kept in proportion to their target function
+    vec4 reservoir = emptyReservoir();
+    for (int k = 0; k < CANDIDATES; k++) {
+        int light = min(int(random(state) * float(lightCount)), lightCount - 1);
+        float weight = targetFunction(light, worldPosition, normal, viewDir, diffuse, ao) * float(lightCount);
+        updateReservoir(reservoir, light, weight, state);
+    }
+    reservoir.z = float(CANDIDATES);
+    finalizeReservoir(reservoir, targetFunction(int(reservoir.x), worldPosition, normal, viewDir, diffuse, ao));
+
+    // Temporal reuse: the reservoir of the same surface point last frame
+    vec4 previousClip = previousViewProjection * vec4(worldPosition, 1.0);
+    vec2 previousUV = previousClip.xy / previousClip.w * 0.5 + 0.5;
+    if (temporalReuse == 1 && previousClip.w > 0.0 && all(greaterThanEqual(previousUV, vec2(0.0))) &&
+        all(lessThanEqual(previousUV, vec2(1.0)))) {
+        vec4 previousPosition = texture(previousPositions, previousUV);
+        if (previousPosition.w > 0.0 && distance(previousPosition.xyz, worldPosition) < 0.01 * -fragPos.z) {
+            vec4 previous = texture(previousReservoirs, previousUV);
+            previous.z = min(previous.z, TEMPORAL_MAX_M * reservoir.z);
+            float target = targetFunction(int(previous.x), worldPosition, normal, viewDir, diffuse, ao);
+            combineReservoir(reservoir, previous, target, state);
+            finalizeReservoir(reservoir, targetFunction(int(reservoir.x), worldPosition, normal, viewDir, diffuse, ao));
+        }
+    }
+
+    reservoirOut = reservoir;
+    positionOut = vec4(worldPosition, 1.0);
+}
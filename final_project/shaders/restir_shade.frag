@@ -0,0 +1,62 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D ssao;
+
+uniform sampler2D reservoirs;
+
+#include "common/lights.glsl"
+#include "common/shading.glsl"
+#include "common/reservoir.glsl"
+
+// Spatial reuse: neighbours merged into the reservoir of each pixel
+#define SPATIAL_NEIGHBOURS 4
+#define SPATIAL_RADIUS 16.0
+
+void main() {
+    if (gBufferUnlit(TexCoords)) {
+        FragColor = vec4(0.0);
+        return;
+    }
+
+    vec3 fragPos = gBufferViewPosition(TexCoords);
+    vec3 worldPosition = gBufferWorldPosition(fragPos);
+    vec3 normal = gBufferNormal(TexCoords);
+    vec3 diffuse = texture(gAlbedo, TexCoords).rgb;
+    float ao = texture(ssao, TexCoords).r;
+    vec3 viewDir = normalize(-fragPos);
+    uint state = initRandom(gl_FragCoord.xy, 1);
+
+    vec2 texelSize = 1.0 / vec2(textureSize(reservoirs, 0));
+    vec4 reservoir = texture(reservoirs, TexCoords);
+    for (int k = 0; k < SPATIAL_NEIGHBOURS; k++) {
+        float angle = 6.2831853 * random(state);
+        float radius = SPATIAL_RADIUS * sqrt(random(state));
+        vec2 uv = TexCoords + vec2(cos(angle), sin(angle)) * radius * texelSize;
+        if (any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0))))
+            continue;
+
+        // Only neighbours on a similar surface share their light samples
+        vec3 neighbourNormal = gBufferNormal(uv);
+        float neighbourDepth = gBufferViewDepth(uv);
+        if (dot(normal, neighbourNormal) < 0.9 || abs(neighbourDepth + fragPos.z) > 0.1 * -fragPos.z)
+            continue;
+
+        vec4 neighbour = texture(reservoirs, uv);
+        float target = targetFunction(int(neighbour.x), worldPosition, normal, viewDir, diffuse, ao);
+        combineReservoir(reservoir, neighbour, target, state);
+    }
+    int light = int(reservoir.x);
+    finalizeReservoir(reservoir, targetFunction(light, worldPosition, normal, viewDir, diffuse, ao));
+
+    // A single shadow map lookup per pixel, whatever the light count
+    vec3 radiance = vec3(0.0);
+    if (light >= 0 && light < lightCount)
+        radiance = evaluateLight(fetchLight(light), light, worldPosition, normal, viewDir, diffuse, ao, true) *
+                   reservoir.w;
+
+    // Divided by the albedo so the denoiser does not blur the textures
+    FragColor = vec4(radiance / max(diffuse, vec3(0.02)), 1.0);
+}
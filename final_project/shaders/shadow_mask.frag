@@ -0,0 +1,28 @@
+#version 330 core
+// Visibility of the lights of each slot, 4 per target
+layout(location = 0) out vec4 mask0;
+layout(location = 1) out vec4 mask1;
+
+// Light of each slot, -1 for an empty one
+uniform ivec4 maskLights[2];
+// Screen pixels per mask texel along each axis
+uniform int scale;
+
+#include "common/lights.glsl"
+#include "common/shading.glsl"
+
+void main() {
+    vec4 visibility[2] = vec4[2](vec4(1.0), vec4(1.0));
+    ivec2 pixel = min(shadowMaskSource(ivec2(gl_FragCoord.xy), scale), textureSize(gDepth, 0) - 1);
+    if (!gBufferUnlitAt(pixel)) {
+        vec3 worldPosition = gBufferWorldPosition(gBufferViewPositionAt(pixel));
+        vec3 normal = gBufferNormalAt(pixel);
+        for (int slot = 0; slot < SHADOW_MASK_LIGHTS; slot++) {
+            int i = maskLights[slot / 4][slot % 4];
+            if (i >= 0)
+                visibility[slot / 4][slot % 4] = lightShadow(fetchLight(i), i, worldPosition, normal);
+        }
+    }
+    mask0 = visibility[0];
+    mask1 = visibility[1];
+}
@@ -0,0 +1,42 @@
+#version 330 core
+#include "common/shadow_moments.glsl"
+
+out vec4 FragColor;
+
+// The depth atlas when fromDepth, moments otherwise
+uniform sampler2D source;
+uniform bool fromDepth;
+// Texels of the source the view covers, reads are clamped to them
+uniform ivec4 sourceRect;
+// Corner of the rectangle written, whose texels map one to one to sourceRect
+uniform ivec2 targetCorner;
+// One texel along the blurred axis
+uniform ivec2 direction;
+// 1 and the near and far planes of perspective views, whose depth is linearized first
+uniform vec3 linearize;
+
+// Binomial weights of the 5 taps
+const float weights[3] = float[](6.0 / 16.0, 4.0 / 16.0, 1.0 / 16.0);
+
+vec4 fetchMoments(ivec2 texel) {
+    texel = clamp(texel, sourceRect.xy, sourceRect.xy + sourceRect.zw - 1);
+    if (!fromDepth)
+        return texelFetch(source, texel, 0);
+
+    float depth = texelFetch(source, texel, 0).x;
+    if (linearize.x > 0.0) {
+        float near = linearize.y;
+        float far = linearize.z;
+        float viewDepth = 2.0 * near * far / (far + near - (2.0 * depth - 1.0) * (far - near));
+        depth = (viewDepth - near) / (far - near);
+    }
+    return depthMoments(depth);
+}
+
+void main() {
+    ivec2 texel = sourceRect.xy + ivec2(gl_FragCoord.xy) - targetCorner;
+    vec4 moments = weights[0] * fetchMoments(texel);
+    for (int i = 1; i < 3; i++)
+        moments += weights[i] * (fetchMoments(texel + i * direction) + fetchMoments(texel - i * direction));
+    FragColor = moments;
+}
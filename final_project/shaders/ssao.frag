@@ -1,27 +1,29 @@
 #version 330 core
+#include "common/uniform_blocks.glsl"
+#include "common/gbuffer.glsl"
+
 out float FragColor;
 
 in vec2 TexCoords;
 
-uniform sampler2D gPosition;
-uniform sampler2D gNormal;
 uniform sampler2D texNoise;
 
-uniform vec3 samples[64];
-
 // Configurable parameters
 int kernelSize = 64;
 float radius = 0.5;
 float bias = 0.025;
 
-const vec2 noiseScale = vec2(1024.0/4.0, 768.0/4.0);
-
-uniform mat4 projection;
-
 void main()
 {
-    vec3 fragPos = texture(gPosition, TexCoords).xyz;
-    vec3 normal = normalize(texture(gNormal, TexCoords).rgb);
+    // Nothing to occlude, SSAOBlurPass skips these pixels
+    if (gBufferUnlit(TexCoords)) {
+        FragColor = 1.0;
+        return;
+    }
+
+    vec2 noiseScale = viewport.xy / 4.0;
+    vec3 fragPos = gBufferViewPosition(TexCoords);
+    vec3 normal = gBufferNormal(TexCoords);
     vec3 randomVec = normalize(texture(texNoise, TexCoords * noiseScale).xyz);
 
     // Create TBN change-of-basis matrix: from tangent-space to view-space
@@ -33,7 +35,7 @@ void main()
     for (int i = 0; i < kernelSize; ++i)
     {
         // Get sample position
-        vec3 samplePos = TBN * samples[i];
+        vec3 samplePos = TBN * ssaoSamples[i].xyz;
         samplePos = fragPos + samplePos * radius;
 
         // Get position on screen/texture
@@ -45,7 +47,7 @@ void main()
         // Transform to range 0 - 1
         offset.xyz = offset.xyz * 0.5 + 0.5;
 
-        float sampleDepth = texture(gPosition, offset.xy).z;
+        float sampleDepth = -gBufferViewDepth(offset.xy);
 
         // Range check and accumulate
         float rangeCheck = smoothstep(0.0, 1.0, radius / abs(fragPos.z - sampleDepth));
@@ -0,0 +1,10 @@
+#version 330 core
+// Written instead of the material attributes, whatever the overdraw costs only these 8 bytes per fragment
+layout (location = 2) out uvec2 visibility;
+
+uniform int drawID;
+
+void main()
+{
+    visibility = uvec2(uint(drawID), uint(gl_PrimitiveID));
+}
@@ -0,0 +1,96 @@
+#version 330 core
+// Shades the pixels of the visibility buffer covered by the draws of one object, once per pixel: fetches the corners
+// of the visible triangle, intersects it with the view ray of the pixel for perspective correct barycentrics, and
+// writes what geometry.frag would have.
+#include "common/uniform_blocks.glsl"
+#include "common/draw_data.glsl"
+#include "common/materials.glsl"
+#include "common/octahedral.glsl"
+#include "common/vertex_fetch.glsl"
+#include "common/visibility.glsl"
+
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedo;
+
+in vec2 TexCoords;
+
+uniform usampler2D visibility;
+uniform sampler2DArray textureArray;
+// Draw IDs of the object being resolved, first and past the last
+uniform ivec2 resolveDraws;
+
+// Barycentrics, in the view space triangle abc, of the point its plane is hit at by the view ray through ndc
+vec3 rayBarycentrics(vec2 ndc, vec3 a, vec3 b, vec3 c) {
+    vec4 far = inverseProjection * vec4(ndc, 1.0, 1.0);
+    vec3 direction = far.xyz / far.w;
+    vec3 ab = b - a;
+    vec3 ac = c - a;
+    vec3 p = cross(direction, ac);
+    float determinant = dot(ab, p);
+    // Edge on, the ray runs along the plane
+    if (abs(determinant) < 1e-20)
+        determinant = 1e-20;
+    float u = dot(-a, p) / determinant;
+    float v = dot(direction, cross(-a, ab)) / determinant;
+    return vec3(1.0 - u - v, u, v);
+}
+
+// Normal of the skinned vertex up to its length: the cofactor matrix of the skin, its inverse transpose scaled by
+// the determinant, costs three cross products where inverse() costs a full 3x3 inversion
+vec3 skinNormal(DrawRecord draw, mat4 skin, vec3 normal) {
+    if (draw.firstJoint < 0)
+        return normal;
+
+    mat3 m = mat3(skin);
+    mat3 cofactors = mat3(cross(m[1], m[2]), cross(m[2], m[0]), cross(m[0], m[1]));
+    return dot(m[0], cofactors[0]) < 0.0 ? -(cofactors * normal) : cofactors * normal;
+}
+
+void main()
+{
+    uvec2 ids = texelFetch(visibility, ivec2(gl_FragCoord.xy), 0).xy;
+    int id = int(ids.x);
+    if (ids.x == VISIBILITY_NONE || id < resolveDraws.x || id >= resolveDraws.y)
+        discard;
+
+    DrawRecord draw = fetchDrawRecordAt(id);
+    ivec3 triangle = fetchTriangle(draw.firstIndex, int(ids.y));
+    FetchedVertex corners[3] = FetchedVertex[3](fetchVertex(triangle.x), fetchVertex(triangle.y),
+                                                fetchVertex(triangle.z));
+
+    // Same transforms as geometry.vert, corner by corner. The camera's view is rigid, so it is its own normal matrix
+    // and only the skin, when there is one, varies between the corners.
+    mat4 modelView = view * draw.model;
+    mat3 normalMatrix = mat3(view) * draw.normalMatrix;
+    vec3 positions[3];
+    mat3 normals;
+    mat3x2 uvs;
+    mat4 colors = mat4(0.0);
+    for (int k = 0; k < 3; k++) {
+        mat4 skin = skinMatrix(draw, corners[k].joints, corners[k].weights);
+        positions[k] = (modelView * skin * vec4(corners[k].position, 1.0)).xyz;
+        normals[k] = normalize(normalMatrix * skinNormal(draw, skin, corners[k].normal));
+        uvs[k] = corners[k].uv;
+        colors[k] = corners[k].color;
+    }
+
+    // The neighbouring pixels' rays give the texture coordinate derivatives, inside the triangle or not
+    vec2 pixelSize = 2.0 * viewport.zw;
+    vec2 ndc = gl_FragCoord.xy * pixelSize - 1.0;
+    vec3 barycentrics = rayBarycentrics(ndc, positions[0], positions[1], positions[2]);
+    vec3 barycentricsX = rayBarycentrics(ndc + vec2(pixelSize.x, 0.0), positions[0], positions[1], positions[2]);
+    vec3 barycentricsY = rayBarycentrics(ndc + vec2(0.0, pixelSize.y), positions[0], positions[1], positions[2]);
+
+    vec2 uv = uvs * barycentrics;
+    vec4 color = colors * vec4(barycentrics, 0.0);
+
+    Material material = fetchMaterial(draw.material);
+    vec4 baseColor = material.colorLayer != -1
+                     ? textureGrad(textureArray, vec3(uv, material.colorLayer), uvs * barycentricsX - uv,
+                                   uvs * barycentricsY - uv)
+                     : color;
+    baseColor *= material.baseColorFactor;
+
+    gNormal = octahedralEncode(normalize(normals * barycentrics));
+    gAlbedo = vec4(baseColor.rgb, float(gBufferMaterialID(draw.material)) / 255.0);
+}
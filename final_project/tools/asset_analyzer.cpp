@@ -0,0 +1,266 @@
+// Loads a glTF through the GltfObject import code, without creating a window or touching OpenGL, and prints
+// what the scene will cost once uploaded: geometry per primitive and of its shadow proxy, draws, texture array
+// layers, skinning and animation data and an estimate of the VRAM footprint. The report is JSON so CI can apply budget rules on it.
+// Usage: asset_analyzer <file.gltf> [more.gltf...]
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <tiny_gltf.h>
+
+#include "3D_objects/gltf_object/GltfObject.h"
+
+// Attributes uploaded by GltfObject::bindMesh, everything else is left on the CPU
+static const std::set<std::string> uploadedAttributes = {
+    "POSITION", "NORMAL", "TEXCOORD_0", "JOINTS_0", "WEIGHTS_0", "COLOR_0"
+};
+
+static std::string escape(const std::string &value) {
+    std::string escaped;
+    for (const char c: value) {
+        switch (c) {
+            case '"': escaped += "\\\"";
+                break;
+            case '\\': escaped += "\\\\";
+                break;
+            case '\n': escaped += "\\n";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    escaped += buffer;
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
+
+static size_t triangleCount(const int mode, const size_t count) {
+    switch (mode) {
+        case TINYGLTF_MODE_TRIANGLES: return count / 3;
+        case TINYGLTF_MODE_TRIANGLE_STRIP:
+        case TINYGLTF_MODE_TRIANGLE_FAN: return count >= 3 ? count - 2 : 0;
+        default: return 0;
+    }
+}
+
+struct PrimitiveCost {
+    int mesh;
+    int primitive;
+    int material;
+    int mode;
+    size_t vertices;
+    size_t indices;
+    size_t triangles;
+    // Triangles of the primitive's depth part with the default ShadowProxySettings, 0 if it was merged
+    size_t proxyTriangles;
+    size_t vertexBytes;
+    size_t indexBytes;
+};
+
+// Mesh and index in it of a primitive of the model
+static void findPrimitive(const tinygltf::Model &model, const tinygltf::Primitive *primitive, int &mesh, int &index) {
+    for (mesh = 0; mesh < model.meshes.size(); mesh++) {
+        const std::vector<tinygltf::Primitive> &primitives = model.meshes[mesh].primitives;
+        if (primitive >= primitives.data() && primitive < primitives.data() + primitives.size()) {
+            index = static_cast<int>(primitive - primitives.data());
+            return;
+        }
+    }
+    mesh = index = -1;
+}
+
+// Cost of every draw record GltfObject builds, in order. bindMesh uploads, for every record, the whole buffer
+// views of its indices and of the attributes it knows.
+static std::vector<PrimitiveCost> collectPrimitives(const tinygltf::Model &model, const GltfLoadStats &stats) {
+    std::vector<PrimitiveCost> costs;
+    for (const DrawRecord &draw: stats.drawRecords) {
+        const tinygltf::Primitive &primitive = *draw.primitive;
+        const tinygltf::Accessor &indexAccessor = model.accessors[primitive.indices];
+        PrimitiveCost cost{};
+        findPrimitive(model, &primitive, cost.mesh, cost.primitive);
+        cost.material = draw.material;
+        cost.mode = static_cast<int>(draw.mode);
+        cost.indices = draw.count;
+        cost.triangles = triangleCount(cost.mode, cost.indices);
+        cost.indexBytes = model.bufferViews[indexAccessor.bufferView].byteLength;
+
+        for (const auto &attrib: primitive.attributes) {
+            const tinygltf::Accessor &accessor = model.accessors[attrib.second];
+            if (attrib.first == "POSITION")
+                cost.vertices = accessor.count;
+            if (uploadedAttributes.count(attrib.first))
+                cost.vertexBytes += model.bufferViews[accessor.bufferView].byteLength;
+        }
+        costs.push_back(cost);
+    }
+
+    for (const DepthPart &part: stats.depthStream.parts)
+        if (part.drawRecord >= 0)
+            costs[part.drawRecord].proxyTriangles = triangleCount(static_cast<int>(part.mode), part.count);
+    return costs;
+}
+
+// Layers of one texture array that hold the same image as an earlier layer
+static size_t writeDuplicatedLayers(std::ostream &out, const tinygltf::Model &model, const std::vector<int> &textures) {
+    std::map<int, std::vector<int> > layersPerImage;
+    for (int layer = 0; layer < textures.size(); layer++)
+        layersPerImage[model.textures[textures[layer]].source].push_back(layer);
+
+    size_t duplicated = 0;
+    bool first = true;
+    out << "[";
+    for (const auto &[image, layers]: layersPerImage) {
+        if (layers.size() < 2)
+            continue;
+        duplicated += layers.size() - 1;
+
+        out << (first ? "" : ",") << "\n        {\"image\": " << image << ", \"uri\": \""
+                << escape(model.images[image].uri) << "\", \"layers\": [";
+        for (int i = 0; i < layers.size(); i++)
+            out << (i ? ", " : "") << layers[i];
+        out << "]}";
+        first = false;
+    }
+    out << (first ? "]" : "\n      ]");
+    return duplicated;
+}
+
+static bool analyze(std::ostream &out, const std::string &filename) {
+    tinygltf::Model model;
+
+    // The loader logs to std::cout, keep stdout for the report
+    std::streambuf *stdoutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+    const bool loaded = GltfObject::loadModel(model, filename.c_str());
+    std::cout.rdbuf(stdoutBuffer);
+    if (!loaded)
+        return false;
+
+    // Loaded as the scene loads it, animated if it has skins
+    const GltfLoadStats stats = GltfObject::buildLoadStats(model, !model.skins.empty(), ShadowProxySettings());
+    const std::vector<PrimitiveCost> primitives = collectPrimitives(model, stats);
+
+    const MaterialLayers layers = GltfObject::loadMaterials(model);
+    const std::vector<SkinObject> skins = GltfObject::prepareSkinning(model);
+    const std::vector<AnimationObject> animations = GltfObject::prepareAnimation(model);
+
+    size_t vertices = 0, triangles = 0, vertexBytes = 0, indexBytes = 0;
+    out << "  {\n    \"file\": \"" << escape(filename) << "\",\n    \"primitives\": [";
+    for (int i = 0; i < primitives.size(); i++) {
+        const PrimitiveCost &p = primitives[i];
+        out << (i ? "," : "") << "\n      {\"mesh\": " << p.mesh << ", \"primitive\": " << p.primitive
+                << ", \"material\": " << p.material << ", \"mode\": " << p.mode << ", \"vertices\": " << p.vertices
+                << ", \"indices\": " << p.indices << ", \"triangles\": " << p.triangles << ", \"proxyTriangles\": "
+                << p.proxyTriangles << "}";
+        vertices += p.vertices;
+        triangles += p.triangles;
+        vertexBytes += p.vertexBytes;
+        indexBytes += p.indexBytes;
+    }
+    out << (primitives.empty() ? "]" : "\n    ]") << ",\n";
+
+    // The merged part of the triangle lists, with ShadowProxySettings::merge, belongs to no single primitive
+    const DepthStream &depth = stats.depthStream;
+    size_t proxyTriangles = 0;
+    for (const DepthPart &part: depth.parts)
+        proxyTriangles += triangleCount(static_cast<int>(part.mode), part.count);
+
+    out << "    \"geometry\": {\"vertices\": " << vertices << ", \"triangles\": " << triangles
+            << ", \"proxyTriangles\": " << proxyTriangles << ", \"drawsPerPass\": " << primitives.size()
+            << ", \"depthParts\": " << depth.parts.size() << "},\n";
+    out << "    \"materials\": " << model.materials.size() << ",\n";
+
+    constexpr size_t layerBytes = static_cast<size_t>(TEXTURE_ARRAY_SIZE) * TEXTURE_ARRAY_SIZE * 4;
+    const size_t colorLayers = layers.baseColorTexturesIndices.size();
+    const size_t metallicRoughnessLayers = layers.metallicRoughnessTexturesIndices.size();
+    const size_t textureBytes = (colorLayers + metallicRoughnessLayers) * layerBytes;
+
+    out << "    \"textureArrays\": {\n      \"layerSize\": " << TEXTURE_ARRAY_SIZE
+            << ",\n      \"baseColorLayers\": " << colorLayers
+            << ",\n      \"metallicRoughnessLayers\": " << metallicRoughnessLayers
+            << ",\n      \"bytes\": " << textureBytes << ",\n      \"duplicatedBaseColor\": ";
+    size_t duplicated = writeDuplicatedLayers(out, model, layers.baseColorTexturesIndices);
+    out << ",\n      \"duplicatedMetallicRoughness\": ";
+    duplicated += writeDuplicatedLayers(out, model, layers.metallicRoughnessTexturesIndices);
+    out << ",\n      \"duplicatedLayers\": " << duplicated << ",\n      \"duplicatedBytes\": "
+            << duplicated * layerBytes << "\n    },\n";
+
+    size_t maxJoints = 0;
+    out << "    \"skinning\": {\"skins\": " << skins.size() << ", \"joints\": [";
+    for (int i = 0; i < skins.size(); i++) {
+        out << (i ? ", " : "") << skins[i].jointMatrices.size();
+        maxJoints = std::max(maxJoints, skins[i].jointMatrices.size());
+    }
+    out << "], \"maxJoints\": " << maxJoints << ", \"jointLimit\": " << MAX_JOINTS
+            << ", \"withinLimit\": " << (maxJoints <= MAX_JOINTS ? "true" : "false") << "},\n";
+
+    size_t channels = 0, keyframes = 0;
+    out << "    \"animations\": [";
+    for (int i = 0; i < model.animations.size(); i++) {
+        size_t animationKeyframes = 0;
+        for (const SamplerObject &sampler: animations[i].samplers)
+            animationKeyframes += sampler.input.size();
+        channels += model.animations[i].channels.size();
+        keyframes += animationKeyframes;
+
+        out << (i ? "," : "") << "\n      {\"name\": \"" << escape(model.animations[i].name)
+                << "\", \"channels\": " << model.animations[i].channels.size() << ", \"samplers\": "
+                << model.animations[i].samplers.size() << ", \"keyframes\": " << animationKeyframes << "}";
+    }
+    out << (model.animations.empty() ? "]" : "\n    ]") << ",\n";
+    out << "    \"animationTotals\": {\"channels\": " << channels << ", \"keyframes\": " << keyframes << "},\n";
+
+    // Vertex fetch buffers: VERTEX_FETCH_TEXELS vec4 per vertex and the triangles unrolled into lists, only built
+    // when every draw is made of triangles
+    size_t fetchVertices = 0, fetchIndices = 0;
+    bool fetched = true;
+    for (const PrimitiveCost &p: primitives) {
+        fetchVertices += p.vertices;
+        fetchIndices += 3 * p.triangles;
+        fetched = fetched && (p.mode == TINYGLTF_MODE_TRIANGLES || p.mode == TINYGLTF_MODE_TRIANGLE_STRIP ||
+                              p.mode == TINYGLTF_MODE_TRIANGLE_FAN);
+    }
+    // Depth only stream as initDepthBuffers uploads it, with 16 bit indices when the vertices allow it
+    const size_t depthVertices = depth.stride ? depth.vertices.size() / depth.stride : 0;
+    const size_t depthBytes = depth.vertices.size() +
+                              depth.indices.size() * (depthVertices <= 65536 ? sizeof(uint16_t) : sizeof(uint32_t));
+    const size_t fetchBytes = fetched
+                                  ? fetchVertices * VERTEX_FETCH_TEXELS * 4 * sizeof(float) +
+                                    fetchIndices * sizeof(uint32_t)
+                                  : 0;
+    const size_t materialBytes = MATERIAL_TEXELS * 4 * sizeof(float) * std::max<size_t>(model.materials.size(), 1);
+
+    // Render targets, shadow maps and the per-frame rings belong to the passes, not to the asset
+    out << "    \"vram\": {\"vertexBuffers\": " << vertexBytes << ", \"indexBuffers\": " << indexBytes
+            << ", \"depthBuffers\": " << depthBytes << ", \"vertexFetchBuffers\": " << fetchBytes
+            << ", \"materialTable\": " << materialBytes << ", \"textureArrays\": " << textureBytes
+            << ", \"total\": " << vertexBytes + indexBytes + depthBytes + fetchBytes + materialBytes + textureBytes
+            << "}\n  }";
+    return true;
+}
+
+int main(const int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.gltf> [more.gltf...]" << std::endl;
+        return 1;
+    }
+
+    std::ostringstream report;
+    report << "[\n";
+    for (int i = 1; i < argc; i++) {
+        if (i > 1)
+            report << ",\n";
+        if (!analyze(report, argv[i])) {
+            std::cerr << "Failed to load " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    report << "\n]";
+
+    std::cout << report.str() << std::endl;
+    return 0;
+}
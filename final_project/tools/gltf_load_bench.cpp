@@ -0,0 +1,166 @@
+// Compares the streaming glTF loader against tinygltf on the same file: load time and number of heap
+// allocations, with and without image decoding, and checks that both produce the same model.
+// Usage: gltf_load_bench <file.gltf> [iterations]
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <tiny_gltf.h>
+
+#include "loaders/gltf_fast_loader/GltfFastLoader.h"
+
+static size_t allocationCount = 0;
+static size_t allocatedBytes = 0;
+
+void *operator new(const size_t size) {
+    allocationCount++;
+    allocatedBytes += size;
+    if (void *ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+struct BenchResult {
+    double ms = 0.0;
+    size_t allocations = 0;
+    size_t bytes = 0;
+};
+
+template<typename Load>
+static BenchResult bench(const int iterations, Load load) {
+    BenchResult result;
+    for (int i = 0; i < iterations; i++) {
+        tinygltf::Model model;
+        const size_t allocationsBefore = allocationCount;
+        const size_t bytesBefore = allocatedBytes;
+        const auto start = std::chrono::steady_clock::now();
+
+        if (!load(model)) {
+            std::cerr << "Load failed" << std::endl;
+            std::exit(1);
+        }
+
+        result.ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        result.allocations += allocationCount - allocationsBefore;
+        result.bytes += allocatedBytes - bytesBefore;
+    }
+    result.ms /= iterations;
+    result.allocations /= iterations;
+    result.bytes /= iterations;
+    return result;
+}
+
+static bool noImageLoader(tinygltf::Image *, int, std::string *, std::string *, int, int, const unsigned char *, int,
+                          void *) {
+    return true;
+}
+
+static bool sameModel(const tinygltf::Model &a, const tinygltf::Model &b) {
+    bool same = a.accessors.size() == b.accessors.size() && a.bufferViews.size() == b.bufferViews.size() &&
+                a.nodes.size() == b.nodes.size() && a.meshes.size() == b.meshes.size() &&
+                a.materials.size() == b.materials.size() && a.textures.size() == b.textures.size() &&
+                a.images.size() == b.images.size() && a.skins.size() == b.skins.size() &&
+                a.animations.size() == b.animations.size() && a.buffers.size() == b.buffers.size() &&
+                a.defaultScene == b.defaultScene;
+    if (!same)
+        return false;
+
+    for (size_t i = 0; i < a.accessors.size(); i++) {
+        const auto &x = a.accessors[i];
+        const auto &y = b.accessors[i];
+        same &= x.bufferView == y.bufferView && x.byteOffset == y.byteOffset && x.componentType == y.componentType &&
+                x.count == y.count && x.type == y.type && x.minValues == y.minValues && x.maxValues == y.maxValues;
+    }
+    for (size_t i = 0; i < a.nodes.size(); i++) {
+        const auto &x = a.nodes[i];
+        const auto &y = b.nodes[i];
+        same &= x.mesh == y.mesh && x.skin == y.skin && x.children == y.children && x.matrix == y.matrix &&
+                x.translation == y.translation && x.rotation == y.rotation && x.scale == y.scale;
+    }
+    for (size_t i = 0; i < a.meshes.size(); i++) {
+        same &= a.meshes[i].primitives.size() == b.meshes[i].primitives.size();
+        for (size_t j = 0; j < a.meshes[i].primitives.size() && same; j++) {
+            const auto &x = a.meshes[i].primitives[j];
+            const auto &y = b.meshes[i].primitives[j];
+            same &= x.attributes == y.attributes && x.indices == y.indices && x.material == y.material &&
+                    x.mode == y.mode;
+        }
+    }
+    for (size_t i = 0; i < a.materials.size(); i++) {
+        same &= a.materials[i].pbrMetallicRoughness == b.materials[i].pbrMetallicRoughness &&
+                a.materials[i].emissiveFactor == b.materials[i].emissiveFactor &&
+                a.materials[i].values.size() == b.materials[i].values.size();
+    }
+    for (size_t i = 0; i < a.images.size(); i++) {
+        same &= a.images[i].width == b.images[i].width && a.images[i].image == b.images[i].image;
+    }
+    for (size_t i = 0; i < a.buffers.size(); i++) {
+        same &= a.buffers[i].data == b.buffers[i].data;
+    }
+    return same;
+}
+
+static void printRow(const std::string &name, const BenchResult &result, const BenchResult &reference) {
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(10) << result.ms << " ms" << std::setw(10) << result.allocations << " allocs"
+            << std::setw(12) << result.bytes / 1024 << " KiB" << std::setw(9)
+            << reference.ms / result.ms << "x" << std::endl;
+}
+
+int main(const int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.gltf> [iterations]" << std::endl;
+        return 1;
+    }
+    const std::string filename = argv[1];
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    std::string err;
+    std::string warn;
+
+    const auto tinyFull = bench(iterations, [&](tinygltf::Model &model) {
+        tinygltf::TinyGLTF loader;
+        return loader.LoadASCIIFromFile(&model, &err, &warn, filename);
+    });
+    const auto fastFull = bench(iterations, [&](tinygltf::Model &model) {
+        return GltfFastLoader::loadASCIIFromFile(model, err, warn, filename);
+    });
+    const auto tinyNoImages = bench(iterations, [&](tinygltf::Model &model) {
+        tinygltf::TinyGLTF loader;
+        loader.SetImageLoader(noImageLoader, nullptr);
+        return loader.LoadASCIIFromFile(&model, &err, &warn, filename);
+    });
+    GltfFastLoader::Stats stats;
+    const auto fastNoImages = bench(iterations, [&](tinygltf::Model &model) {
+        return GltfFastLoader::loadASCIIFromFile(model, err, warn, filename, false, &stats);
+    });
+
+    tinygltf::Model reference;
+    tinygltf::Model candidate;
+    tinygltf::TinyGLTF loader;
+    loader.LoadASCIIFromFile(&reference, &err, &warn, filename);
+    GltfFastLoader::loadASCIIFromFile(candidate, err, warn, filename);
+
+    std::cout << filename << " (" << stats.jsonBytes / 1024 << " KiB of JSON, " << reference.accessors.size()
+            << " accessors, " << reference.nodes.size() << " nodes, " << reference.materials.size()
+            << " materials), average of " << iterations << " runs" << std::endl;
+    printRow("tinygltf", tinyFull, tinyFull);
+    printRow("fast loader", fastFull, tinyFull);
+    printRow("tinygltf (no images)", tinyNoImages, tinyNoImages);
+    printRow("fast loader (no images)", fastNoImages, tinyNoImages);
+    std::cout << "fast loader breakdown: json " << stats.jsonMs << " ms, buffers " << stats.buffersMs << " ms"
+            << std::endl;
+    std::cout << "models match: " << (sameModel(reference, candidate) ? "yes" : "NO") << std::endl;
+
+    return 0;
+}
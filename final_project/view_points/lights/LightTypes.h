@@ -5,5 +5,6 @@
 
 enum LightTypes {
     POINT_LIGHT,
-    SPOT_LIGHT
+    SPOT_LIGHT,
+    DIRECTIONAL_LIGHT
 };
@@ -0,0 +1,120 @@
+#include "DirectionalLight.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <glm/gtc/matrix_transform.hpp>
+
+DirectionalLight::DirectionalLight(const float lightIntensity, const glm::vec3 lightColor, const float viewAzimuth,
+                                   const float viewPolar) : Light(glm::vec3(0.0f), lightIntensity, lightColor,
+                                                                  viewAzimuth, viewPolar) {
+}
+
+glm::vec3 DirectionalLight::getDirection() const {
+    return normalize(getLookAt() - getPosition());
+}
+
+float DirectionalLight::getRange() const {
+    return std::numeric_limits<float>::infinity();
+}
+
+LightTypes DirectionalLight::getType() const {
+    return DIRECTIONAL_LIGHT;
+}
+
+lightStruct DirectionalLight::toStruct() const {
+    lightStruct dStruct = Light::toStruct();
+    dStruct.spaceMatrix = getCascadeMatrix(0);
+    dStruct.direction = getDirection();
+    return dStruct;
+}
+
+void DirectionalLight::updateCascades(const ViewPoint &camera) {
+    const glm::vec3 direction = getDirection();
+    const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), direction, up);
+
+    const glm::mat4 inverseCameraView = inverse(camera.getViewMatrix());
+    const glm::mat4 cameraProjection = camera.getProjectionMatrix();
+    const float tanX = 1.0f / cameraProjection[0][0];
+    const float tanY = 1.0f / cameraProjection[1][1];
+    const float near = camera.getNear();
+    const float far = std::min(camera.getFar(), CSM_DISTANCE);
+
+    float sliceNear = near;
+    for (int c = 0; c < CSM_CASCADES; c++) {
+        const float t = static_cast<float>(c + 1) / CSM_CASCADES;
+        const float sliceFar = CSM_SPLIT_LAMBDA * near * std::pow(far / near, t) +
+                               (1.0f - CSM_SPLIT_LAMBDA) * (near + (far - near) * t);
+
+        // Sphere around the slice, centered on the view axis: its radius only depends on the projection
+        const float centerDepth = 0.5f * (sliceNear + sliceFar);
+        const float farCorner = glm::length(glm::vec3(tanX * sliceFar, tanY * sliceFar, sliceFar - centerDepth));
+        const float nearCorner = glm::length(glm::vec3(tanX * sliceNear, tanY * sliceNear, sliceNear - centerDepth));
+        const float sliceRadius = std::max(farCorner, nearCorner);
+        // Padded by one more texel, the snapped center may move by up to that much: radius = padded + texel with
+        // texel = 2 * radius / CSM_SNAP_TEXELS, so that the box is exactly CSM_SNAP_TEXELS snap steps wide
+        const float radius = sliceRadius * (1.0f + CSM_REFIT_MARGIN) / (1.0f - 2.0f / CSM_SNAP_TEXELS);
+        const float texel = 2.0f * radius / CSM_SNAP_TEXELS;
+
+        const glm::vec3 sliceCenter = glm::vec3(inverseCameraView * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f));
+        slices[c] = glm::vec4(sliceCenter, sliceRadius);
+        const glm::vec3 center = glm::floor(glm::vec3(view * glm::vec4(sliceCenter, 1.0f)) / texel) * texel;
+
+        // Looking down -z, with the near plane pulled back to catch casters between the light and the slice
+        CascadeFit &target = targets[c];
+        target.view = view;
+        target.projection = glm::ortho(center.x - radius, center.x + radius, center.y - radius, center.y + radius,
+                                       -center.z - radius - CSM_CASTER_DISTANCE, -center.z + radius);
+        target.split = sliceFar;
+        target.center = center;
+        target.radius = radius;
+        sliceNear = sliceFar;
+    }
+}
+
+bool DirectionalLight::isCascadeCurrent(const int cascade) const {
+    const CascadeFit &target = targets[cascade];
+    const CascadeFit &current = cascades[cascade];
+    return committed[cascade] && target.view == current.view && target.projection == current.projection &&
+           target.split == current.split;
+}
+
+bool DirectionalLight::coversSlice(const int cascade) const {
+    if (!committed[cascade] || targets[cascade].split != cascades[cascade].split)
+        return false;
+
+    // The slice sphere, in the committed light space, inside the committed box
+    const CascadeFit &current = cascades[cascade];
+    const glm::vec3 center = glm::vec3(current.view * glm::vec4(glm::vec3(slices[cascade]), 1.0f));
+    return glm::all(glm::lessThanEqual(glm::abs(center - current.center),
+                                       glm::vec3(current.radius - slices[cascade].w)));
+}
+
+void DirectionalLight::commitCascade(const int cascade) {
+    if (isCascadeCurrent(cascade))
+        return;
+    cascades[cascade] = targets[cascade];
+    committed[cascade] = true;
+    invalidate();
+}
+
+glm::mat4 DirectionalLight::getTargetMatrix(const int cascade) const {
+    return targets[cascade].projection * targets[cascade].view;
+}
+
+glm::mat4 DirectionalLight::getCascadeView(const int cascade) const {
+    return cascades[cascade].view;
+}
+
+glm::mat4 DirectionalLight::getCascadeProjection(const int cascade) const {
+    return cascades[cascade].projection;
+}
+
+glm::mat4 DirectionalLight::getCascadeMatrix(const int cascade) const {
+    return cascades[cascade].projection * cascades[cascade].view;
+}
+
+float DirectionalLight::getCascadeSplit(const int cascade) const {
+    return cascades[cascade].split;
+}
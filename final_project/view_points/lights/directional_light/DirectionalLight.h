@@ -0,0 +1,83 @@
+#ifndef DIRECTIONALLIGHT_H
+#define DIRECTIONALLIGHT_H
+#include <glm/glm.hpp>
+
+#include "../light/Light.h"
+#include "view_points/lights/LightTypes.h"
+
+// Orthographic shadow cascades over the camera frustum, mirrored in shaders/common/uniform_blocks.glsl
+#define CSM_CASCADES 4
+// View depth covered by the cascades, past it the light casts no shadow
+#define CSM_DISTANCE 500.0f
+// Blend between uniform (0) and logarithmic (1) split depths
+#define CSM_SPLIT_LAMBDA 0.75f
+// How far towards the light from a cascade's bounds casters are still rendered into it
+#define CSM_CASTER_DISTANCE 200.0f
+// Cascades move by whole texels of a map this large, and so by whole texels of any larger power of two map
+#define CSM_SNAP_TEXELS 256
+// Fraction of its radius each cascade is padded by, so the camera and the light can move a little before the
+// cascade no longer covers its slice
+#define CSM_REFIT_MARGIN 0.1f
+
+// Where a cascade is and what it covers
+struct CascadeFit {
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    // Far view depth of the slice
+    float split = 0.0f;
+    // Light space center and half size of the cascade's box
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+
+// Light without position or falloff, such as the sun. Its shadow is split into CSM_CASCADES orthographic maps,
+// each fitted to the bounding sphere of a depth slice of the camera frustum. A sphere does not change with the
+// camera rotation and its center is snapped to the texel grid, so the shadow edges do not shimmer.
+//
+// updateCascades only fits targets. A cascade keeps what it was last rendered with, which the lighting reads,
+// until commitCascade adopts its target, so the cascades can be refreshed on different frames.
+class DirectionalLight : public Light {
+    CascadeFit targets[CSM_CASCADES];
+    CascadeFit cascades[CSM_CASCADES];
+    bool committed[CSM_CASCADES] = {};
+
+    // World space bounding sphere of each target's slice, without the margin
+    glm::vec4 slices[CSM_CASCADES];
+
+public:
+    DirectionalLight(float lightIntensity, glm::vec3 lightColor, float viewAzimuth, float viewPolar);
+
+    [[nodiscard]] glm::vec3 getDirection() const;
+
+    // Lights everything, however far
+    [[nodiscard]] float getRange() const override;
+
+    [[nodiscard]] LightTypes getType() const override;
+
+    [[nodiscard]] lightStruct toStruct() const override;
+
+    // Fits the target of every cascade to the camera
+    void updateCascades(const ViewPoint &camera);
+
+    // Whether the cascade already is its target
+    [[nodiscard]] bool isCascadeCurrent(int cascade) const;
+
+    // Whether the committed cascade still contains its target's slice
+    [[nodiscard]] bool coversSlice(int cascade) const;
+
+    // Adopts the target of the cascade, invalidates the light if it changed
+    void commitCascade(int cascade);
+
+    // Matrix the cascade would be rendered with once committed
+    [[nodiscard]] glm::mat4 getTargetMatrix(int cascade) const;
+
+    [[nodiscard]] glm::mat4 getCascadeView(int cascade) const;
+
+    [[nodiscard]] glm::mat4 getCascadeProjection(int cascade) const;
+
+    [[nodiscard]] glm::mat4 getCascadeMatrix(int cascade) const;
+
+    [[nodiscard]] float getCascadeSplit(int cascade) const;
+};
+
+#endif //DIRECTIONALLIGHT_H
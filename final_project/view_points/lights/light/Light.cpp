@@ -4,6 +4,7 @@
 
 #include "Light.h"
 
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 #include "view_points/lights/LightTypes.h"
 
@@ -22,26 +23,87 @@ glm::vec3 Light::getColor() const {
     return lightColor;
 }
 
+float Light::getRange() const {
+    return std::sqrt(lightIntensity / LIGHT_ATTENUATION_CUTOFF);
+}
+
 LightTypes Light::getType() const {
     return POINT_LIGHT;
 }
 
 lightStruct Light::toStruct() const {
     lightStruct lStruct;
-    lStruct.type = getType();
+    lStruct.type = static_cast<float>(getType());
     lStruct.position = getPosition();
     lStruct.intensity = getIntensity();
     lStruct.color = getColor();
-    lStruct.spaceMatrix = getVPMatrix();
-    lStruct.padding1 = 0;
-    lStruct.padding2 = 0;
+    lStruct.spaceMatrix = getParaboloidView(0);
+    lStruct.shadowFade = shadowFade;
     lStruct.innerConeAngle = 0;
     lStruct.outerConeAngle = 0;
+    lStruct.shadowNear = POINT_SHADOW_NEAR;
     lStruct.direction = glm::vec3(0, 0, 0);
-    lStruct.padding3 = 0;
+    lStruct.shadowFar = getRange();
+    lStruct.shadowRect = shadowRect;
+    lStruct.shadowMaskSlot = static_cast<float>(shadowMaskSlot);
+    lStruct.padding = glm::vec3(0.0f);
     return lStruct;
 }
 
 float Light::getAspectRatio() const {
     return 1.0f;
 }
+
+glm::mat4 Light::getParaboloidView(const int hemisphere) const {
+    const glm::mat4 front = getViewMatrix();
+    return hemisphere == 0 ? front : glm::scale(glm::mat4(1.0f), glm::vec3(-1.0f, 1.0f, -1.0f)) * front;
+}
+
+float Light::getShadowImportance() const {
+    return shadowImportance;
+}
+
+void Light::setShadowImportance(const float importance) {
+    shadowImportance = importance;
+}
+
+bool Light::castsShadows() const {
+    return shadowCaster;
+}
+
+void Light::setCastsShadows(const bool castsShadows) {
+    shadowCaster = castsShadows;
+}
+
+float Light::getShadowFade() const {
+    return shadowFade;
+}
+
+void Light::setShadowFade(const float fade) {
+    if (fade == shadowFade)
+        return;
+    shadowFade = fade;
+    invalidate();
+}
+
+glm::vec4 Light::getShadowRect() const {
+    return shadowRect;
+}
+
+void Light::setShadowRect(const glm::vec4 rect) {
+    if (rect == shadowRect)
+        return;
+    shadowRect = rect;
+    invalidate();
+}
+
+int Light::getShadowMaskSlot() const {
+    return shadowMaskSlot;
+}
+
+void Light::setShadowMaskSlot(const int slot) {
+    if (slot == shadowMaskSlot)
+        return;
+    shadowMaskSlot = slot;
+    invalidate();
+}
@@ -9,22 +9,36 @@
 #include "../LightTypes.h"
 #include "view_points/view_point/ViewPoint.h"
 
+// Attenuation (intensity / distance²) below which a light no longer contributes visibly, even after gamma
+#define LIGHT_ATTENUATION_CUTOFF (1.0f / 4096.0f)
+// Nearest distance a point light's paraboloid shadow maps keep, their depth is linear up to the light's range
+#define POINT_SHADOW_NEAR 0.1f
+
 struct lightStruct {
     glm::vec3 position;
     float intensity;
 
     glm::vec3 color;
-    float padding1;
+    // Weight of the shadow map, 0 for an unshadowed light
+    float shadowFade;
 
     glm::mat4 spaceMatrix;
 
-    int type;
+    // Integers are stored as floats, their bit patterns would be denormals or NaNs in the RGBA32F light buffer
+    float type;
     float innerConeAngle;
     float outerConeAngle;
-    float padding2;
+    // Depth range of a point light's paraboloid shadow maps, or of a spotlight's frustum
+    float shadowNear;
 
     glm::vec3 direction;
-    float padding3;
+    float shadowFar;
+
+    glm::vec4 shadowRect;
+
+    // Channel of the shadow mask holding the light's visibility, -1 when the lighting samples its shadow map
+    float shadowMaskSlot;
+    glm::vec3 padding;
 };
 
 class Light : public ViewPoint{
@@ -33,6 +47,13 @@ class Light : public ViewPoint{
         glm::vec3 lightColor;
         glm::vec3 lookAt;
 
+        float shadowImportance = 1.0f;
+        bool shadowCaster = true;
+        float shadowFade = 0.0f;
+        // Tile of the shadow atlas: offset and size in texture coordinates, no shadow map if the size is 0
+        glm::vec4 shadowRect = glm::vec4(0.0f);
+        int shadowMaskSlot = -1;
+
     public:
         ~Light() override = default;
 
@@ -40,9 +61,34 @@ class Light : public ViewPoint{
 
         [[nodiscard]] float getIntensity() const;
         [[nodiscard]] glm::vec3 getColor() const;
+        // Distance at which the attenuation falls under LIGHT_ATTENUATION_CUTOFF
+        [[nodiscard]] virtual float getRange() const;
         [[nodiscard]] virtual LightTypes getType() const;
         [[nodiscard]] virtual lightStruct toStruct() const;
         [[nodiscard]] float getAspectRatio() const override;
+
+        // Point lights are shadowed by two paraboloid maps. The front hemisphere (0) is seen down the light's
+        // view direction, the back one (1) turned around the y axis.
+        [[nodiscard]] glm::mat4 getParaboloidView(int hemisphere) const;
+
+        // Scales the share of the shadow atlas the light gets for its screen coverage
+        [[nodiscard]] float getShadowImportance() const;
+        void setShadowImportance(float importance);
+
+        // Lights that do not cast shadows never get a shadow map, however much they contribute
+        [[nodiscard]] bool castsShadows() const;
+        void setCastsShadows(bool castsShadows);
+
+        // Set by ShadowAtlas, 1 when the light is fully shadowed
+        [[nodiscard]] float getShadowFade() const;
+        void setShadowFade(float fade);
+
+        [[nodiscard]] glm::vec4 getShadowRect() const;
+        void setShadowRect(glm::vec4 rect);
+
+        // Set by ShadowMask, -1 when the light has no channel in the shadow mask
+        [[nodiscard]] int getShadowMaskSlot() const;
+        void setShadowMaskSlot(int slot);
 };
 
 
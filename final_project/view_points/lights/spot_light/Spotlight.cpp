@@ -10,6 +10,9 @@ Spotlight::Spotlight(glm::vec3 lightPosition, float lightIntensity, glm::vec3 li
     lightPosition, lightIntensity, lightColor, viewAzimuth, viewPolar) {
     this->innerConeAngle = glm::radians(innerConeAngle);
     this->outerConeAngle = glm::radians(outerConeAngle);
+
+    // The shadow frustum only has to contain the cone, the outer angle is measured from the axis
+    setFieldOfView(2.0f * outerConeAngle + SPOTLIGHT_SHADOW_FOV_MARGIN, 1.0f);
 }
 
 float Spotlight::getInnerConeAngle() const {
@@ -26,8 +29,11 @@ LightTypes Spotlight::getType() const {
 
 lightStruct Spotlight::toStruct() const {
     lightStruct sStruct = Light::toStruct();
+    sStruct.spaceMatrix = getVPMatrix();
     sStruct.innerConeAngle = getInnerConeAngle();
     sStruct.outerConeAngle = getOuterConeAngle();
+    sStruct.shadowNear = getNear();
+    sStruct.shadowFar = getFar();
     sStruct.direction = normalize(getLookAt() - getPosition());
     return sStruct;
 }
@@ -9,6 +9,9 @@
 #include "../light/Light.h"
 #include "view_points/lights/LightTypes.h"
 
+// Degrees added to the cone for the shadow frustum, so filtering at the rim stays inside the map
+#define SPOTLIGHT_SHADOW_FOV_MARGIN 2.0f
+
 class Spotlight : public Light {
     float innerConeAngle;
     float outerConeAngle;
@@ -10,6 +10,17 @@
 ViewPoint::ViewPoint(const glm::vec3 position, const float viewAzimuth, const float viewPolar, const float fov,
                      const float near, const float far) : position(position), viewAzimuth(viewAzimuth),
                                                           viewPolar(viewPolar), fov(fov), near(near), far(far) {
+    projectionMatrix = glm::perspective(glm::radians(fov), 4.0f / 3.0f, near, far);
+}
+
+void ViewPoint::invalidate() {
+    version++;
+}
+
+void ViewPoint::setFieldOfView(const float fov, const float aspectRatio) {
+    this->fov = fov;
+    projectionMatrix = glm::perspective(glm::radians(fov), aspectRatio, near, far);
+    invalidate();
 }
 
 glm::vec3 ViewPoint::getLookAt() const {
@@ -38,14 +49,17 @@ glm::vec3 ViewPoint::getUp() const {
 
 void ViewPoint::setPosition(const glm::vec3 position) {
     this->position = position;
+    invalidate();
 }
 
 void ViewPoint::setViewAzimuth(const float viewAzimuth) {
     this->viewAzimuth = viewAzimuth;
+    invalidate();
 }
 
 void ViewPoint::setViewPolar(const float viewPolar) {
     this->viewPolar = viewPolar;
+    invalidate();
 }
 
 glm::mat4 ViewPoint::getViewMatrix() const {
@@ -53,9 +67,21 @@ glm::mat4 ViewPoint::getViewMatrix() const {
 }
 
 glm::mat4 ViewPoint::getProjectionMatrix() const {
-    return glm::perspective(glm::radians(fov), 4.0f / 3.0f, near, far);
+    return projectionMatrix;
 }
 
 glm::mat4 ViewPoint::getVPMatrix() const {
     return getProjectionMatrix() * getViewMatrix();
 }
+
+float ViewPoint::getNear() const {
+    return near;
+}
+
+float ViewPoint::getFar() const {
+    return far;
+}
+
+unsigned int ViewPoint::getVersion() const {
+    return version;
+}
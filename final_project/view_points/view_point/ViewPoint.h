@@ -6,6 +6,7 @@
 #define VIEWPOINT_H
 #include <glm/detail/type_mat.hpp>
 #include <glm/detail/type_vec3.hpp>
+#include <glm/detail/type_mat4x4.hpp>
 
 class ViewPoint {
 private:
@@ -18,6 +19,19 @@ private:
     float near;
     float far;
 
+    // Depends on fov, near, far and the aspect ratio. setFieldOfView rebuilds it and bumps the version.
+    glm::mat4 projectionMatrix;
+
+    // Incremented by every setter, so caches of derived data know when to rebuild
+    unsigned int version = 0;
+
+protected:
+    // Marks the derived data of this view point as stale
+    void invalidate();
+
+    // Replaces the projection, for views whose frustum is fitted after construction
+    void setFieldOfView(float fov, float aspectRatio);
+
 public:
     virtual ~ViewPoint() = default;
 
@@ -45,6 +59,12 @@ public:
 
     [[nodiscard]] glm::mat4 getVPMatrix() const;
 
+    [[nodiscard]] float getNear() const;
+
+    [[nodiscard]] float getFar() const;
+
+    [[nodiscard]] unsigned int getVersion() const;
+
     [[nodiscard]] virtual float getAspectRatio() const = 0;
 };
 